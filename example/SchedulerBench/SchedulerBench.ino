@@ -0,0 +1,174 @@
+/* Scheduler - micro benchmarks
+
+  Created 2016
+  by Paul Carpenter
+
+  Measures cost of scheduler functions so builds can be compared and changes
+  checked before updating deployed firmware. Runs once from setup( ) and
+  sends results to serial port (115,200 baud) as CSV lines of
+
+        bench,tasks,stats,logging,param,ns
+
+    bench       name of measurement
+    tasks       number of tasks in table (BENCH_TASKS in Tasklist.h)
+    stats       1 statistics compiled in, 0 DISABLE_STATS
+    logging     1 logging compiled in, 0 DISABLE_LOGGING
+    param       extra parameter of measurement (or -)
+    ns          average time in ns
+
+  Measurements
+    run_pass    one pass of Run with param percent of tasks due, tasks are
+                empty so this is scheduler overhead for the pass
+    run_early   call of Run that is too early (most calls from loop)
+    start       Start of a stopped task
+    setinterval setInterval of a task
+    findid      FindID searching whole table (worst case)
+    snapshot    copy of task table as done at end of each pass
+
+  Table size is set at compile time, build with BENCH_TASKS 16, 64, 256, 1024,
+  4096 and DISABLE_STATS/DISABLE_LOGGING in Tasklist.h (or from compiler
+  command line with -D) to compare. Only needs serial port so runs on any
+  board or Arduino core for Linux hosts.
+*/
+#include <Arduino.h>
+#include "Schedule.h"
+
+// Number of passes or calls to average over
+#define PASSES  20
+#define CALLS   1000
+
+#ifdef DISABLE_STATS
+#define _STATS 0
+#else
+#define _STATS 1
+#endif
+#ifdef DISABLE_LOGGING
+#define _LOGGING 0
+#else
+#define _LOGGING 1
+#endif
+
+// Buffer for snapshot copy
+struct TaskList copyTable[ _MAX_TASKS ];
+
+// Percentages of tasks due for run_pass
+const int duePercent[ ] = { 0, 25, 50, 100 };
+
+void benchRun( );
+void benchCalls( );
+
+
+void setup( )
+{
+Serial.begin( 115200 );
+Init( );
+Serial.println( "bench,tasks,stats,logging,param,ns" );
+benchRun( );
+benchCalls( );
+Serial.println( "done" );
+}
+
+
+void loop( )
+{
+}
+
+
+/* Task - empty task always runs every interval set by benchmark */
+int benchTask( int ID, int status )
+{
+return 2;
+}
+
+
+/* Never in task list so FindID searches whole table */
+int benchMissing( int ID, int status )
+{
+return 0;
+}
+
+
+// Output one CSV line of results
+void result( const char *bench, int param, unsigned long total, unsigned long count )
+{
+Serial.print( bench );
+Serial.write( ',' );
+Serial.print( (unsigned long)_MAX_TASKS, DEC );
+Serial.write( ',' );
+Serial.print( _STATS, DEC );
+Serial.write( ',' );
+Serial.print( _LOGGING, DEC );
+Serial.write( ',' );
+if( param < 0 )
+  Serial.print( "-" );
+else
+  Serial.print( param, DEC );
+Serial.write( ',' );
+Serial.println( (unsigned long)( (unsigned long long)total * 1000 / count ), DEC );
+}
+
+
+/* Time Run passes with different amounts of tasks due
+   Due tasks have interval of MIN_TASK_INTERVAL and each pass is started as
+   soon as MIN_TASK_INTERVAL has passed, others have longest interval */
+void benchRun( )
+{
+int i, j, due, pass;
+unsigned long ms, us, total;
+
+for( i = 0; i < (int)( sizeof( duePercent ) / sizeof( int ) ); i++ )
+   {
+   due = (int)( (long)_MAX_TASKS * duePercent[ i ] / 100 );
+   for( j = 0; j < (int)_MAX_TASKS; j++ )
+      setInterval( j, j < due ? MIN_TASK_INTERVAL : 32767 );
+   total = 0;
+   ms = millis( );
+   for( pass = 0; pass < PASSES; pass++ )
+      {
+      while( millis( ) - ms < MIN_TASK_INTERVAL );
+      us = micros( );
+      Run( );
+      total += micros( ) - us;
+      ms = millis( );
+      }
+   result( "run_pass", duePercent[ i ], total, PASSES );
+   }
+// Straight after a pass so all these calls are too early
+us = micros( );
+for( i = 0; i < CALLS; i++ )
+   Run( );
+result( "run_early", -1, micros( ) - us, CALLS );
+}
+
+
+/* Time helper function calls */
+void benchCalls( )
+{
+int i, ID;
+unsigned long us;
+
+ID = _MAX_TASKS - 1;
+us = micros( );
+for( i = 0; i < CALLS; i++ )
+   {
+   taskTable[ ID ].status = 0;          // stopped so Start does full work
+   Start( ID );
+   }
+result( "start", -1, micros( ) - us, CALLS );
+
+us = micros( );
+for( i = 0; i < CALLS; i++ )
+   setInterval( ID, 100 + ( i & 7 ) );
+result( "setinterval", -1, micros( ) - us, CALLS );
+
+us = micros( );
+for( i = 0; i < CALLS; i++ )
+   if( FindID( benchMissing ) >= 0 )
+     break;
+result( "findid", -1, micros( ) - us, CALLS );
+
+us = micros( );
+for( i = 0; i < CALLS; i++ )
+   memcpy( copyTable, taskTable, sizeof( copyTable ) );
+result( "snapshot", -1, micros( ) - us, CALLS );
+}
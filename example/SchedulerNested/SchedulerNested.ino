@@ -0,0 +1,102 @@
+/* Scheduler - sub-scheduler timing test
+
+  Created 2016
+  by Paul Carpenter
+
+  Checks a sub-scheduler keeps its own timing when run as a task of the
+  parent scheduler, even when the parent's tasks before it take a varying
+  time. Parent (Tasklist.h, MIN_TASK_INTERVAL 10) has two tasks
+
+    jitterTask  every 10 ms, with jitter on takes 3 ms every other run so
+                SubTask starts a varying time into each parent pass
+    SubTask     made by SubLoop.cpp, runs sub-scheduler Sub (SubTasks.h,
+                its own MIN_TASK_INTERVAL 10) every 10 ms
+
+  Sub-scheduler has one task, subTask, every 10 ms. Each test runs for
+  TEST_TIME ms, first without then with jitter, subTask should run once
+  for every parent pass either way.
+
+  Results sent to serial port (115,200 baud) as CSV lines of
+
+        test,jitter,runs,expected,result
+
+    runs        times subTask ran
+    expected    parent passes in the time (TEST_TIME / 10)
+    result      PASS when runs is at least 95% of expected, else FAIL
+
+  Only needs a serial port so runs on any board or Arduino core for Linux
+  hosts.
+*/
+#include <Arduino.h>
+#include "Schedule.h"
+
+// Time of each test in ms
+#define TEST_TIME   2000
+
+int jitter = 0;                 // jitterTask takes 3 ms every other run
+unsigned long subRuns = 0;      // runs of sub-scheduler's task (SubLoop.cpp)
+int testing = 1;                // cleared when all tests done
+unsigned long testStart;
+
+
+void setup( )
+{
+Serial.begin( 115200 );
+Serial.println( "test,jitter,runs,expected,result" );
+Init( );
+testStart = millis( );
+subRuns = 0;
+}
+
+
+void loop( )
+{
+if( !testing )
+  return;
+Run( );
+if( millis( ) - testStart < TEST_TIME )
+  return;
+result( );
+if( jitter )
+  {
+  testing = 0;
+  Serial.println( "done" );
+  }
+jitter = 1;
+testStart = millis( );
+subRuns = 0;
+}
+
+
+/* Task - every 10 ms, 3 ms every other run when jitter is on */
+int jitterTask( int ID, int status )
+{
+static int odd = 0;
+
+if( status == 0 )
+  {
+  setInterval( ID, 10 );
+  return 1;
+  }
+odd = !odd;
+if( jitter && odd )
+  delay( 3 );
+return 1;
+}
+
+
+// Output CSV line of results of one test
+void result( )
+{
+unsigned long expected;
+
+expected = TEST_TIME / 10;
+Serial.print( "subrate," );
+Serial.print( jitter, DEC );
+Serial.write( ',' );
+Serial.print( subRuns, DEC );
+Serial.write( ',' );
+Serial.print( expected, DEC );
+Serial.write( ',' );
+Serial.println( subRuns * 100 >= expected * 95 ? "PASS" : "FAIL" );
+}
@@ -0,0 +1,26 @@
+/* Sub-scheduler Sub of SchedulerNested, run by parent task SubTask
+
+   Builds Schedule.cpp again in namespace Sub with task list SubTasks.h,
+   its task is defined in the namespace below.
+*/
+#include <Arduino.h>
+#define SCHEDULE_NAME       Sub
+#define SCHEDULE_TASKLIST   "SubTasks.h"
+#define SCHEDULE_TASK       SubTask
+#include "Schedule.cpp"
+
+extern unsigned long subRuns;
+
+namespace Sub {
+/* subTask - Count runs every 10 ms */
+int subTask( int ID, int status )
+{
+if( status == 0 )
+  {
+  setInterval( ID, 10 );            // Sub::setInterval
+  return 1;
+  }
+subRuns++;
+return 1;
+}
+}
@@ -44,7 +44,9 @@ Run         Main scheduling loop each call is one loop of checking if time
             to run tasks and executing them in order on the list.
 Init        Initialise all tasks in list
 Log         Get pointer to copy of task table
+LogTask     Get one task from copy at full width
 getStats    Get pointer to structure of general statistics) and reset maximums
+getUsage    Get pointer to CPU use of each task and scheduler
 setInterval Set a task's NEW interval and schedule new time from now if not
             already running
 getInterval Get a task's interval
@@ -52,6 +54,19 @@ getTime     Get a tasks next time to execute
 getStatus   Get a particular schedule status word
 Start       Start a task (if not already running)
 FindID      Get ID of task from task address
+Trigger     Make a started task due now (for events)
+getNextRun  Get time when Run next has something to do
+setDegrade  Let a task have its interval stretched when overloaded
+getDegrade  Get how much a task's interval is stretched
+timerStart  Start a software timer to call a function after a delay
+timerStop   Stop a software timer
+StartAfter  Start a task after a delay using a software timer
+groupStart  Start all tasks of a group at next pass
+groupStop   Stop all tasks of a group at next pass
+groupSuspend Hold all tasks of a group at next pass, keeping status
+groupResume Carry on tasks of a group held by groupSuspend at next pass
+groupScale  Scale intervals of all tasks of a group at next pass
+getSuspended Get if a task is held by groupSuspend
 
 Structure of task code.
 -----------------------
@@ -85,16 +100,207 @@ Structure of task code.
           > 0 Next status
                 1 start
                 2 - 32767 User status
+
+Sub-schedulers
+--------------
+    A task can run a scheduler of its own, with its own task list,
+    MIN_TASK_INTERVAL, settings, statistics and Log, so a subsystem has its
+    own timing and the main task list stays short. The sub-scheduler is a
+    .cpp file of the sketch that includes this file with these defined first
+
+        SCHEDULE_NAME       namespace for all of it e.g. Fast so functions
+                            are Fast::Run, Fast::getStats...
+        SCHEDULE_TASKLIST   its task list, a copy of Tasklist.h renamed
+        SCHEDULE_TASK       name of task made to run it, put in tasks of
+                            the parent's task list and declared there
+        SCHEDULE_INTERVAL   interval of that task in parent, default own
+                            MIN_TASK_INTERVAL (TICK_MIN adaptive tick),
+                            not less. Parent must be able to run it that
+                            often or the task stops with status -3
+        SCHEDULE_PARENT     namespace of parent, not defined for main
+                            scheduler
+
+    e.g.    #include <Arduino.h>
+            #define SCHEDULE_NAME       Fast
+            #define SCHEDULE_TASKLIST   "FastTasks.h"
+            #define SCHEDULE_TASK       FastTask
+            #include "Schedule.cpp"
+
+    Task list and everything in it (including types like Fast::Stats) is in
+    the namespace, so task functions of a sub-scheduler are too, declared
+    at top of its task list with no includes there. Files with its tasks or
+    that use its functions include Schedule.h with the same SCHEDULE_NAME
+    and SCHEDULE_TASKLIST defined first. A file can only use one scheduler
+    by name, the main one or one sub-scheduler. Linux thread, watchdog,
+    shared memory and telemetry are for the main scheduler only.
 */
 #include <Arduino.h>
+#ifdef SCHEDULE_NAME
+namespace SCHEDULE_NAME {
+#include SCHEDULE_TASKLIST
+}
+#else
 #include "Tasklist.h"
+#endif
+#if defined( __linux__ ) && defined( ENABLE_LINUX_WATCHDOG )
+#include <pthread.h>
+#define _WATCH
+#endif
+/* Clock for task and pass times
+   CLOCK_NOW( )             read clock
+   CLOCK_ELAPSED( start )   time since CLOCK_NOW( ) was start
+   _CLOCK_MS                clock times in 1 ms
+   Normally micros( ), with ENABLE_CYCLE_CLOCK processor cycle counter scaled
+   to ns (clockScale is ns per count times 2^24, set by clockInit) */
+#ifdef ENABLE_CYCLE_CLOCK
+#if defined( __ARM_ARCH_7M__ ) || defined( __ARM_ARCH_7EM__ )
+#define _DEMCR          ( *(volatile unsigned long *)0xE000EDFC )
+#define _DWT_CTRL       ( *(volatile unsigned long *)0xE0001000 )
+#define _DWT_CYCCNT     ( *(volatile unsigned long *)0xE0001004 )
+#define _DWT_LAR        ( *(volatile unsigned long *)0xE0001FB0 )
+#define _CLOCK_COUNT( ) _DWT_CYCCNT
+#elif defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#include <time.h>
+#define _CLOCK_COUNT( ) ( (unsigned long)__rdtsc( ) )
+#elif defined( __aarch64__ ) && defined( __linux__ )
+static inline unsigned long clockCount( )
+{
+unsigned long count;
+
+__asm__ __volatile__( "isb; mrs %0, cntvct_el0" : "=r" ( count ) :: "memory" );
+return count;
+}
+#define _CLOCK_COUNT( ) clockCount( )
+#else
+#error ENABLE_CYCLE_CLOCK needs Cortex-M3/M4/M7, x86 or 64 bit ARM Linux
+#endif
+#define CLOCK_NOW( )            _CLOCK_COUNT( )
+#define CLOCK_ELAPSED( start )  ( (unsigned long)( (unsigned long long)( _CLOCK_COUNT( ) - ( start ) ) \
+                                                   * clockScale >> 24 ) )
+#define _CLOCK_MS               1000000UL
+#else
+#define CLOCK_NOW( )            micros( )
+#define CLOCK_ELAPSED( start )  ( micros( ) - ( start ) )
+#define _CLOCK_MS               1000UL
+#endif
+#ifdef ENABLE_DUE_MASK
+// Vector compare of 32 bit next times, not for 16 bit ENABLE_COMPACT
+#if defined( __AVX2__ ) && !defined( ENABLE_COMPACT )
+#include <immintrin.h>
+#define _DUE_AVX2
+#elif defined( __SSE2__ ) && !defined( ENABLE_COMPACT )
+#include <emmintrin.h>
+#define _DUE_SSE2
+#endif
+#endif
+
+// Memory barrier so Trigger from interrupts or threads is seen in order
+#if defined( __AVR__ )
+#define _BARRIER( )     __asm__ __volatile__( "" ::: "memory" )
+#else
+#define _BARRIER( )     __sync_synchronize( )
+#endif
+
+// Instrumentation hooks, define in Tasklist.h to use, otherwise nothing
+#ifndef SCHEDULE_BEFORE_TASK
+#define SCHEDULE_BEFORE_TASK( ID, status )
+#endif
+#ifndef SCHEDULE_AFTER_TASK
+#define SCHEDULE_AFTER_TASK( ID, status, us )
+#endif
+#ifndef SCHEDULE_END_PASS
+#define SCHEDULE_END_PASS( done )
+#endif
 
 // Points in Rolling average for overdue status
 // Recommended values 8 to 32
 #define _MAX_AVERAGE 8
+// Number of tasks checked in normal pass of task list
+#ifdef ENABLE_BACKGROUND
+#define _FORE_TASKS ( _MAX_TASKS - BACKGROUND_TASKS )
+#else
+#define _FORE_TASKS _MAX_TASKS
+#endif
+#if defined( ENABLE_CYCLIC ) && ( defined( ENABLE_DUE_MASK ) || defined( ENABLE_BACKGROUND ) \
+    || defined( ENABLE_PASS_BUDGET ) || defined( ENABLE_STAGGER ) )
+#error ENABLE_CYCLIC cannot be used with ENABLE_DUE_MASK, ENABLE_BACKGROUND, ENABLE_PASS_BUDGET or ENABLE_STAGGER
+#endif
+#if defined( ENABLE_LINKS ) && defined( ENABLE_CYCLIC )
+#error ENABLE_LINKS cannot be used with ENABLE_CYCLIC
+#endif
+#if defined( ENABLE_ADAPTIVE_TICK ) && defined( ENABLE_CYCLIC )
+#error ENABLE_ADAPTIVE_TICK cannot be used with ENABLE_CYCLIC
+#endif
+#if defined( ENABLE_DEGRADE ) && ( defined( DISABLE_STATS ) || defined( ENABLE_CYCLIC ) )
+#error ENABLE_DEGRADE needs statistics and cannot be used with ENABLE_CYCLIC
+#endif
+#if defined( SCHEDULE_NAME ) && ( defined( ENABLE_LINUX_RT ) || defined( ENABLE_LINUX_WATCHDOG ) \
+    || defined( ENABLE_LINUX_SHM ) || defined( ENABLE_TELEMETRY ) )
+#error Sub-scheduler cannot use ENABLE_LINUX_RT, ENABLE_LINUX_WATCHDOG, ENABLE_LINUX_SHM or ENABLE_TELEMETRY
+#endif
+#if defined( ENABLE_PROFILE ) && ( PROFILE_SIZE < 1 || PROFILE_SIZE > 16384 \
+    || ( PROFILE_SIZE & ( PROFILE_SIZE - 1 ) ) )
+#error PROFILE_SIZE must be a power of 2 up to 16384
+#endif
+/* Task next run and last run times
+   _LATE( ID, ms )  ms since task was due (unsigned, large if not due yet)
+   _UNTIL( ID, ms ) ms until task is due (long, < 0 overdue)
+   _LAST( t )       run time as stored
+   _STATUS( s )     status returned by task as stored
+   With ENABLE_COMPACT only low 16 bits of next are kept, and last is 16 bit
+   so longer times are stored as 65535, status is 16 bit so kept to 32767
+   either way rather than wrapping to stopped or an error */
+#ifdef ENABLE_COMPACT
+#define _LATE( ID, ms )     ( (unsigned short)( (unsigned short)( ms ) - taskTable[ ID ].next ) )
+#define _UNTIL( ID, ms )    ( (long)(short)( taskTable[ ID ].next - (unsigned short)( ms ) ) )
+#define _LAST( t )          ( ( t ) > 0xFFFFUL ? 0xFFFF : ( t ) )
+#define _STATUS( s )        ( ( s ) > 32767 ? 32767 : ( ( s ) < -32767 ? -32767 : ( s ) ) )
+#define _MAX_INTERVAL       32767
+#else
+#define _LATE( ID, ms )     ( ( ms ) - taskTable[ ID ].next )
+#define _UNTIL( ID, ms )    ( (long)( taskTable[ ID ].next - ( ms ) ) )
+#define _LAST( t )          ( t )
+#define _STATUS( s )        ( s )
+#endif
+#ifdef ENABLE_GROUPS
+// Number of groups and check of task held by groupSuspend
+#define _GROUPS ( sizeof( taskGroups ) / sizeof( taskGroups[ 0 ] ) )
+#define _SUSPENDED( ID )    ( suspendMask[ ( ID ) >> 5 ] & ( (uint32_t)1 << ( ( ID ) & 31 ) ) )
+#else
+#define _SUSPENDED( ID )    0
+#endif
+#ifdef ENABLE_LINKS
+// Number of task links
+#define _LINKS  ( sizeof( taskLinks ) / sizeof( taskLinks[ 0 ] ) )
+#endif
+#ifdef ENABLE_DUE_MASK
+// Number of 32 bit words for a bitmask over the task table
+#define _MASK_WORDS ( ( _FORE_TASKS + 31 ) / 32 )
+#endif
 
+#ifdef SCHEDULE_NAME
+namespace SCHEDULE_NAME {
+#endif
 unsigned long old_ms;       // last execution time
 int running;                // Current task ID being checked or run
+volatile int triggered = 0; // task made due by Trigger so pass needed
+// Tasks Triggered since last pass, single bytes so set safely from
+// interrupts and other threads, made due at start of next pass
+volatile unsigned char triggerPending[ _MAX_TASKS ];
+#ifdef ENABLE_ADAPTIVE_TICK
+volatile unsigned long nextCheck;   // time of next pass (ms)
+unsigned int tickLate;      // how late pass was started after nextCheck
+#endif
+#ifdef SCHEDULE_TASK
+// Set by SCHEDULE_TASK, Run does a pass at parent's pass time, as parent
+// has already checked it is time for one
+int passForced = 0;
+unsigned long passMs;       // parent's pass time (ms)
+#define _FORCED     passForced
+#else
+#define _FORCED     0
+#endif
 
 // Array of task details
 /* Following structures and copy for snapshots for reporting and analysis
@@ -105,6 +311,47 @@ struct TaskList taskTable[ _MAX_TASKS ];
 #ifndef DISABLE_LOGGING
 struct TaskList tasksCopy[ _MAX_TASKS ];
 #endif
+#ifdef ENABLE_USAGE
+// CPU use of tasks, last entry is scheduler itself
+struct Usage usage[ _MAX_TASKS + 1 ];
+struct Usage usageCopy[ _MAX_TASKS + 1 ];
+unsigned long busy[ _MAX_TASKS + 1 ];   // run time this sample (us)
+unsigned long passTasks = 0;            // run time of tasks this call (us)
+unsigned long sampleStart;              // time sample started (us)
+const unsigned long usageTimes[ USAGE_WINDOWS ] = USAGE_TIMES;
+#endif
+#ifdef ENABLE_PROFILE
+// Run times of each task and state in order first seen, found by hash table
+// of twice the size (entry + 1, 0 empty) so it is never more than half full
+struct Profile profile[ PROFILE_SIZE ];
+unsigned int profileHash[ PROFILE_SIZE * 2 ];
+unsigned int profileQty = 0;            // entries used
+unsigned long profileDropped = 0;       // runs not counted table full
+#endif
+#ifdef ENABLE_LINUX_SHM
+unsigned long taskRuns[ _MAX_TASKS ];   // times each task run
+extern void shmPublish( );              // in ScheduleShm.cpp
+#endif
+#ifdef ENABLE_TELEMETRY
+extern void telePublish( );             // in ScheduleTele.cpp
+#endif
+#ifdef ENABLE_LINUX_RT
+extern void rtWake( );                  // in ScheduleLinux.cpp
+#endif
+#ifdef _WATCH
+// Seen by monitor thread in ScheduleWatch.cpp
+volatile int watchID = -1;              // task running, -1 none
+volatile int watchStatus;               // status task was called with
+volatile unsigned long watchStart;      // time task was called (us)
+volatile unsigned long watchRuns = 0;   // count of task runs
+volatile unsigned long watchBeat = 0;   // count of calls of Run
+pthread_t watchThread;                  // thread calling Run
+extern unsigned long watchWarn[ ];      // in ScheduleWatch.cpp
+extern unsigned long watchOverruns[ ];
+#endif
+#ifdef ENABLE_CYCLE_CLOCK
+unsigned long clockScale;               // ns per count << 24
+#endif
 #ifndef DISABLE_STATS
 // Structure for keeping statistics on scheduling
 struct Stats stats;
@@ -115,6 +362,936 @@ unsigned int overdueTotal = 0;
 int overdueIdx = 0;
 unsigned int overdueAvg[ _MAX_AVERAGE ];
 #endif
+#ifdef ENABLE_DUE_MASK
+// Bitmasks for this pass one bit per task ID, bit 0 of word 0 is ID 0
+uint32_t dueMask[ _MASK_WORDS ];        // enabled and due to run
+uint32_t enabledMask[ _MASK_WORDS ];    // enabled
+#endif
+#ifdef ENABLE_GROUPS
+// Task groups, bitmasks one bit per task ID as taskGroups in Tasklist.h
+uint32_t suspendMask[ _GROUP_WORDS ];   // held by groupSuspend
+// Changes asked for since last pass, applied at start of next pass
+uint32_t pendStart[ _GROUP_WORDS ];
+uint32_t pendStop[ _GROUP_WORDS ];
+uint32_t pendSuspend[ _GROUP_WORDS ];
+uint32_t pendResume[ _GROUP_WORDS ];
+unsigned int pendScale[ _GROUPS ];      // percent to scale intervals, 0 none
+int groupPending = 0;                   // any changes waiting
+/* Interval used is worked out from interval given to setInterval and
+   percent of each group of task, so scaling never loses the interval */
+unsigned int groupPercent[ _GROUPS ];   // percent of group, 0 not scaled
+int baseInterval[ _MAX_TASKS ];         // interval given to setInterval
+void groupApply( );                     // after Start
+long groupInterval( int );              // after groupApply
+#endif
+#ifdef ENABLE_BACKGROUND
+int bgNext = _FORE_TASKS;       // background task to try first next time
+#endif
+#ifdef ENABLE_CYCLIC
+unsigned int frame = 0;         // minor frame to run next pass
+unsigned int lastFrame = 0;     // minor frame run last pass
+int cyclicValid = 0;            // tables checked by Init
+#endif
+#ifdef ENABLE_LINKS
+// Task links, consumers made due by producers run at end of pass
+unsigned char linkProducer[ _MAX_TASKS ];   // task is producer of a link
+unsigned char linkPending[ _MAX_TASKS ];    // consumer made due this pass
+int linkOrder[ _LINKS ];        // consumers in topological order
+int linkQty = 0;                // number of consumers
+int linkDepth[ _MAX_TASKS ];    // links into task not yet placed (Init)
+#endif
+#ifdef ENABLE_DEGRADE
+// Overload control, task interval is used times 2 to power of level
+unsigned char degradeMax[ _MAX_TASKS ];     // highest level, 0 never
+unsigned char degradeLevel[ _MAX_TASKS ];   // current level
+int degradeHold = 0;            // passes to wait before next change
+#endif
+#ifdef ENABLE_STAGGER
+/* Tasks due in each pass of a window of STAGGER_SLOTS passes (each
+   MIN_TASK_INTERVAL ms) from Init, repeating */
+unsigned int staggerLoad[ STAGGER_SLOTS ];
+int staggerSlot[ _MAX_TASKS ];  // first slot of task in window, -1 not in
+int staggerTicks[ _MAX_TASKS ]; // passes between runs when added to window
+unsigned long staggerBase;      // time window started (ms)
+void staggerStop( int );        // after Run
+#endif
+#ifdef ENABLE_PASS_BUDGET
+// Pass split over calls of Run when out of time
+int resumeID = 0;               // task to continue pass from, 0 new pass
+int passDone = 0;               // tasks run so far this pass
+unsigned int passOverdue;       // time since last pass at pass start
+unsigned long callStart;        // time at start of this call of Run (us)
+unsigned long callMs;           // time at start of this call of Run (ms)
+#endif
+#ifdef ENABLE_TIMERS
+// Software timers
+struct Timer    {
+                unsigned long expire;   // expiry time in ms
+                int period;             // repeat period in ms, 0 = one shot
+                void ( *callback )( int, int );  // function to call
+                int arg;                // user value passed to callback
+                };
+struct Timer timers[ MAX_TIMERS ];
+/* Timers waiting to expire as binary heap of timer numbers earliest expiry at
+   top, so only expired timers need checking each pass */
+int timerHeap[ MAX_TIMERS ];
+int timerPos[ MAX_TIMERS ];     // position of timer in heap, -1 not active
+int timerQty = 0;               // number of timers in heap
+int timerFree[ MAX_TIMERS ];    // stack of stopped timers to reuse
+int freeQty = 0;
+int timerUsed = 0;              // timers never used start from here
+#endif
+
+
+#ifdef ENABLE_LINKS
+/* linkCheck - Make consumers of a producer task that has just run pending
+   when producer returned status of link (or any status for LINK_ANY)
+
+   Parameters  int Task ID of producer
+*/
+void linkCheck( int ID )
+{
+int i;
+
+for( i = 0; i < (int)_LINKS; i++ )
+   if( taskLinks[ i ][ 0 ] == ID
+       && ( taskLinks[ i ][ 2 ] == LINK_ANY
+            || taskLinks[ i ][ 2 ] == taskTable[ ID ].status ) )
+     linkPending[ taskLinks[ i ][ 1 ] ] = 1;
+}
+#endif
+
+
+#ifdef ENABLE_CYCLE_CLOCK
+/* clockInit - Start cycle counter and work out ns per count
+   Cortex-M counts at F_CPU, 64 bit ARM Linux reads counter frequency, x86
+   time stamp counter is timed against CLOCK_MONOTONIC for 10 ms
+*/
+void clockInit( )
+{
+unsigned long long rate;
+#if defined( __ARM_ARCH_7M__ ) || defined( __ARM_ARCH_7EM__ )
+
+_DEMCR |= 0x01000000UL;             // enable trace (DWT)
+_DWT_LAR = 0xC5ACCE55UL;            // unlock (Cortex-M7)
+_DWT_CYCCNT = 0;
+_DWT_CTRL |= 1;                     // start cycle counter
+rate = F_CPU;
+#elif defined( __aarch64__ )
+
+__asm__ __volatile__( "mrs %0, cntfrq_el0" : "=r" ( rate ) );
+#else
+struct timespec t0, t1;
+unsigned long long ns;
+unsigned long count;
+
+clock_gettime( CLOCK_MONOTONIC, &t0 );
+count = _CLOCK_COUNT( );
+do
+  {
+  clock_gettime( CLOCK_MONOTONIC, &t1 );
+  ns = ( t1.tv_sec - t0.tv_sec ) * 1000000000ULL + t1.tv_nsec - t0.tv_nsec;
+  }
+while( ns < 10000000ULL );
+count = _CLOCK_COUNT( ) - count;
+rate = count * 1000000000ULL / ns;
+#endif
+clockScale = (unsigned long)( ( 1000000000ULL << 24 ) / rate );
+}
+#endif
+
+
+#ifdef ENABLE_PROFILE
+/* profileAdd - Add run time to entry for task and state it was called with
+   New entry made first time a task and state is seen
+
+   Parameters  int           Task ID
+               int           status task was called with
+               unsigned long time taken (us)
+*/
+void profileAdd( int ID, int status, unsigned long us )
+{
+unsigned int h, entry;
+struct Profile *ptr;
+
+h = (unsigned int)( ( ( (unsigned long)ID << 16 ) ^ (unsigned int)status )
+                    * 2654435761UL >> 16 ) & ( PROFILE_SIZE * 2 - 1 );
+while( ( entry = profileHash[ h ] ) != 0 )
+  {
+  ptr = &profile[ entry - 1 ];
+  if( ptr->ID == ID && ptr->status == status )
+    {
+    ptr->runs++;
+    ptr->total += us;
+    if( us > ptr->max )
+      ptr->max = us;
+    return;
+    }
+  h = ( h + 1 ) & ( PROFILE_SIZE * 2 - 1 );
+  }
+if( profileQty >= PROFILE_SIZE )
+  {
+  profileDropped++;
+  return;
+  }
+ptr = &profile[ profileQty++ ];
+profileHash[ h ] = profileQty;
+ptr->ID = ID;
+ptr->status = status;
+ptr->runs = 1;
+ptr->total = us;
+ptr->max = us;
+}
+#endif
+
+
+/* runTask - Run one task and update its table entry and statistics
+   Common to all methods of working out which tasks are due in Run
+
+   Parameters  int           Task ID to run
+               unsigned long pass start time in ms
+*/
+void runTask( int ID, unsigned long ms )
+{
+unsigned long last_us;
+int status;
+#ifdef ENABLE_PROFILE
+int state;
+
+state = taskTable[ ID ].status;
+#endif
+
+SCHEDULE_BEFORE_TASK( ID, taskTable[ ID ].status );
+#ifdef _WATCH
+watchStatus = taskTable[ ID ].status;
+watchStart = micros( );
+__atomic_store_n( &watchID, ID, __ATOMIC_RELEASE );
+#endif
+last_us = CLOCK_NOW( );
+status = ( *tasks[ ID ])( ID, taskTable[ ID ].status );
+last_us = CLOCK_ELAPSED( last_us );
+taskTable[ ID ].status = _STATUS( status );
+#ifdef _WATCH
+__atomic_store_n( &watchID, -1, __ATOMIC_RELAXED );
+__atomic_store_n( &watchRuns, watchRuns + 1, __ATOMIC_RELEASE );
+if( watchWarn[ ID ] && micros( ) - watchStart >= watchWarn[ ID ] )
+  watchOverruns[ ID ]++;                // every run over warn limit
+#endif
+SCHEDULE_AFTER_TASK( ID, taskTable[ ID ].status, last_us );
+if( taskTable[ ID ].status > 0 )        // process based on new status
+#if defined( ENABLE_DEGRADE ) && defined( ENABLE_COMPACT )
+  taskTable[ ID ].next = ms + ( ( (unsigned long)taskTable[ ID ].interval << degradeLevel[ ID ] )
+                                > _MAX_INTERVAL ? _MAX_INTERVAL
+                                : taskTable[ ID ].interval << degradeLevel[ ID ] );
+#elif defined( ENABLE_DEGRADE )
+  taskTable[ ID ].next = ms + ( (unsigned long)taskTable[ ID ].interval << degradeLevel[ ID ] );
+#else
+  taskTable[ ID ].next = ms + taskTable[ ID ].interval;
+#endif
+#ifdef ENABLE_STAGGER
+else
+  staggerStop( ID );                    // stopped, free its passes
+#endif
+// save execution time
+taskTable[ ID ].last = _LAST( last_us );
+taskTable[ ID ].executed = 1;           // Ran
+#ifdef ENABLE_LINUX_SHM
+taskRuns[ ID ]++;
+#endif
+#ifdef ENABLE_LINKS
+linkPending[ ID ] = 0;                  // consumer has now run
+if( linkProducer[ ID ] )
+  linkCheck( ID );
+#endif
+#ifdef ENABLE_USAGE
+usage[ ID ].runs++;
+usage[ ID ].total += last_us;
+busy[ ID ] += last_us;
+passTasks += last_us;
+#endif
+#ifdef ENABLE_PROFILE
+profileAdd( ID, state, last_us );
+#endif
+#ifndef DISABLE_STATS
+if( last_us > stats.maxExec )           // check if above max execution
+  {
+  stats.maxExec = last_us;              // save max execution time
+  stats.maxID = ID;                     // and task ID
+  }
+#endif
+}
+
+
+#ifdef ENABLE_USAGE
+/* usageUpdate - Add scheduler time for this call of Run to CPU use
+   Called at end of every call of Run, including calls with nothing to do,
+   so scheduler time includes polling from loop( ). Every USAGE_SAMPLE ms
+   work out use in sample of each task and scheduler and update the averages
+   over each window
+
+   Average use is exponentially weighted, each sample adds
+        ( sample - average ) * sample time / window time
+
+   Times are in us (ns with ENABLE_CYCLE_CLOCK)
+
+   Parameters  unsigned long CLOCK_NOW( ) when call of Run started
+*/
+void usageUpdate( unsigned long start_us )
+{
+int i, w;
+unsigned long now, elapsed, sample;
+
+now = CLOCK_NOW( );
+start_us = CLOCK_ELAPSED( start_us ) - passTasks;  // time not in tasks
+passTasks = 0;
+usage[ _MAX_TASKS ].runs++;
+usage[ _MAX_TASKS ].total += start_us;
+busy[ _MAX_TASKS ] += start_us;
+
+elapsed = CLOCK_ELAPSED( sampleStart );
+if( elapsed < USAGE_SAMPLE * _CLOCK_MS )
+  return;
+sampleStart = now;
+for( i = 0; i <= (int)_MAX_TASKS; i++ )
+   {
+   sample = (unsigned long)( (unsigned long long)busy[ i ] * 1000000 / elapsed );
+   if( sample > 1000000 )
+     sample = 1000000;
+   busy[ i ] = 0;
+   for( w = 0; w < USAGE_WINDOWS; w++ )
+      if( elapsed / _CLOCK_MS >= usageTimes[ w ] )
+        usage[ i ].util[ w ] = sample;
+      else
+        usage[ i ].util[ w ] += (long)( ( (long long)sample - (long long)usage[ i ].util[ w ] )
+                                        * (long long)( elapsed / _CLOCK_MS ) / (long long)usageTimes[ w ] );
+   }
+memcpy( usageCopy, usage, sizeof( usage ) );
+}
+#endif
+
+
+#ifdef ENABLE_TIMERS
+/* timerBefore - Compare expiry time of two timers allowing for wrap around
+   Returns  int  non zero if timer a expires before timer b
+*/
+int timerBefore( int a, int b )
+{
+return (long)( timers[ a ].expire - timers[ b ].expire ) < 0;
+}
+
+
+/* timerSwap - Swap two positions in heap updating timer positions */
+void timerSwap( int a, int b )
+{
+int i;
+
+i = timerHeap[ a ];
+timerHeap[ a ] = timerHeap[ b ];
+timerHeap[ b ] = i;
+timerPos[ timerHeap[ a ] ] = a;
+timerPos[ timerHeap[ b ] ] = b;
+}
+
+
+/* timerUp - Move timer at heap position towards top until in order */
+void timerUp( int pos )
+{
+while( pos > 0 && timerBefore( timerHeap[ pos ], timerHeap[ ( pos - 1 ) / 2 ] ) )
+  {
+  timerSwap( pos, ( pos - 1 ) / 2 );
+  pos = ( pos - 1 ) / 2;
+  }
+}
+
+
+/* timerDown - Move timer at heap position towards bottom until in order */
+void timerDown( int pos )
+{
+int child;
+
+while( ( child = 2 * pos + 1 ) < timerQty )
+  {
+  if( child + 1 < timerQty && timerBefore( timerHeap[ child + 1 ], timerHeap[ child ] ) )
+    child++;
+  if( !timerBefore( timerHeap[ child ], timerHeap[ pos ] ) )
+    break;
+  timerSwap( pos, child );
+  pos = child;
+  }
+}
+
+
+/* timerAdd - Add timer to heap */
+void timerAdd( int timer )
+{
+timerHeap[ timerQty ] = timer;
+timerPos[ timer ] = timerQty;
+timerUp( timerQty++ );
+#ifdef ENABLE_ADAPTIVE_TICK
+if( (long)( timers[ timer ].expire - nextCheck ) < 0 )
+  nextCheck = timers[ timer ].expire;
+#endif
+}
+
+
+/* timerRemove - Remove timer from heap */
+void timerRemove( int timer )
+{
+int pos;
+
+pos = timerPos[ timer ];
+timerPos[ timer ] = -1;
+if( pos != --timerQty )
+  {
+  timerHeap[ pos ] = timerHeap[ timerQty ];
+  timerPos[ timerHeap[ pos ] ] = pos;
+  timerUp( pos );
+  timerDown( timerPos[ timerHeap[ pos ] ] );
+  }
+}
+
+
+/* runTimers - Call functions of all expired timers
+   Repeating timers are set for their next expiry before calling function,
+   one shot timers are freed before calling so function can start new timers
+
+   Parameters  unsigned long pass start time in ms
+*/
+void runTimers( unsigned long ms )
+{
+int i;
+
+while( timerQty && (long)( ms - timers[ timerHeap[ 0 ] ].expire ) >= 0 )
+  {
+  i = timerHeap[ 0 ];
+  timerRemove( i );
+  if( timers[ i ].period > 0 )
+    {
+    timers[ i ].expire += timers[ i ].period;
+    if( (long)( ms - timers[ i ].expire ) >= 0 ) // very late do not catch up
+      timers[ i ].expire = ms + timers[ i ].period;
+    timerAdd( i );
+    }
+  else
+    timerFree[ freeQty++ ] = i;
+  ( *timers[ i ].callback )( i, timers[ i ].arg );
+  }
+}
+#endif
+
+
+/* nextDue - Time until next task or timer is due
+   Parameters  unsigned long time now in ms
+               int           number of tasks from start of list to check
+
+   Returns     long ms until next due, < 0 overdue,
+                    0x7FFFFFFF nothing enabled
+*/
+long nextDue( unsigned long ms, int qty )
+{
+int i;
+long due, t;
+
+due = 0x7FFFFFFFL;
+for( i = 0; i < qty; i++ )
+   if( taskTable[ i ].status > 0 && !_SUSPENDED( i ) )
+     {
+     t = _UNTIL( i, ms );
+     if( t < due )
+       due = t;
+     }
+#ifdef ENABLE_TIMERS
+if( timerQty )
+  {
+  t = (long)( timers[ timerHeap[ 0 ] ].expire - ms );
+  if( t < due )
+    due = t;
+  }
+#endif
+return due;
+}
+
+
+#ifdef ENABLE_ADAPTIVE_TICK
+/* tickUpdate - Work out time of next pass at end of a pass
+   Next pass is when next task or timer is due, but not sooner than TICK_MIN
+   or time this pass took (so passes are not back to back) and not later than
+   TICK_MAX from start of this pass. Start, setInterval and timers started
+   after this make it earlier if needed.
+*/
+void tickUpdate( )
+{
+unsigned long ms, tick;
+long due;
+
+ms = millis( );
+tick = ms - old_ms;                 // time this pass took
+if( tick < TICK_MIN )
+  tick = TICK_MIN;
+due = nextDue( ms, _MAX_TASKS );
+if( due > TICK_MAX )
+  due = TICK_MAX;
+due += (long)( ms - old_ms );       // from start of this pass
+if( due > (long)tick )
+  tick = due;
+if( tick > TICK_MAX )
+  tick = TICK_MAX;
+nextCheck = old_ms + tick;
+#ifndef DISABLE_STATS
+stats.tick = tick;
+#endif
+}
+#endif
+
+
+#ifdef ENABLE_BACKGROUND
+/* runBackground - Run background tasks in spare time after a pass
+   Background tasks are the last BACKGROUND_TASKS in list, one is run if
+   enabled, its interval has passed and time to next due task is more than
+   BACKGROUND_SLACK ms. Each background task is run at most once, starting
+   after the last one run so all get a turn when time is short.
+
+   Parameters  NONE
+
+   Returns     int Number of background tasks executed
+*/
+int runBackground( )
+{
+int i, first, done;
+unsigned long ms, deadline;
+#ifndef DISABLE_STATS
+unsigned long start_us;
+
+start_us = micros( );
+#endif
+ms = millis( );
+deadline = ms + nextDue( ms, _FORE_TASKS );
+first = bgNext;
+done = 0;
+for( i = 0; i < BACKGROUND_TASKS; i++ )
+   {
+   running = first + i;
+   if( running >= (int)_MAX_TASKS )
+     running -= BACKGROUND_TASKS;
+   if( taskTable[ running ].status > 0 )      // task enabled
+     {
+     ms = millis( );
+     if( (long)( deadline - ms ) > BACKGROUND_SLACK
+         && _UNTIL( running, ms ) <= 0 && !_SUSPENDED( running ) )
+       {
+       runTask( running, ms );
+       done++;
+       bgNext = running + 1;
+       if( bgNext >= (int)_MAX_TASKS )
+         bgNext = _FORE_TASKS;
+       }
+     else
+       {
+       taskTable[ running ].executed = 0;   // not run
+#ifdef ENABLE_COMPACT
+       // starved too long, keep it due before 16 bit next looks ahead
+       if( _UNTIL( running, ms ) < -16384 )
+         taskTable[ running ].next = ms;
+#endif
+       }
+     }
+   }
+running = (int)_MAX_TASKS;
+#ifndef DISABLE_STATS
+stats.slackUsed = micros( ) - start_us;     // time in background tasks
+stats.bgQty = done;
+#endif
+return done;
+}
+#endif
+
+
+/* runList - ONE pass of task table checking each task in turn
+   Order of task execution is list of tasks
+
+   Parameters  unsigned long pass start time in ms
+               unsigned int  time since last pass in ms
+               int           task ID to start from, 0 new pass
+
+   Returns     int Number of tasks executed
+*/
+int runList( unsigned long ms, unsigned int overdue, int first )
+{
+int done;
+
+done = 0;
+for( running = first; running < (int)_FORE_TASKS; running++ )
+   {
+   if( taskTable[ running ].status > 0 )      // task enabled
+     { // check if time to run as in correct interval or overdue
+     if( _LATE( running, ms ) <= overdue && !_SUSPENDED( running ) )
+       { // run task get new status
+       runTask( running, ms );
+       done++;
+#ifdef ENABLE_PASS_BUDGET
+       if( micros( ) - callStart >= PASS_BUDGET && running + 1 < (int)_FORE_TASKS )
+         {
+         resumeID = running + 1;            // rest of pass on next call
+         running = (int)_MAX_TASKS;
+         return done;
+         }
+#endif
+       }
+     else
+       taskTable[ running ].executed = 0;   // not run
+     }
+   }
+return done;
+}
+
+
+#ifdef ENABLE_DUE_MASK
+/* buildDueMask - Set dueMask and enabledMask bits for whole task table
+   Same check as Run of status > 0 and ms - next <= overdue, done several tasks
+   at a time without branches.
+
+   Tasks held by groupSuspend are taken out of dueMask a word at a time.
+
+   Vector versions (AVX2 8 tasks, SSE2 4 tasks) only compare low 32 bits of the
+   difference, this is exact as an enabled task's next time is always within
+   interval (max 32767 ms) of the pass time. Tasks left over at end of table or
+   without vector support use the scalar loop.
+
+   Parameters  unsigned long pass start time in ms
+               unsigned int  time since last pass in ms
+*/
+void buildDueMask( unsigned long ms, unsigned int overdue )
+{
+int i;
+uint32_t on, due;
+
+for( i = 0; i < (int)_MASK_WORDS; i++ )
+   dueMask[ i ] = enabledMask[ i ] = 0;
+i = 0;
+#if defined( _DUE_AVX2 )
+const int size = sizeof( struct TaskList ) / sizeof( int );
+const __m256i index = _mm256_setr_epi32( 0, size, 2 * size, 3 * size,
+                                         4 * size, 5 * size, 6 * size, 7 * size );
+const __m256i sign = _mm256_set1_epi32( (int)0x80000000 );
+const __m256i zero = _mm256_setzero_si256( );
+const __m256i now = _mm256_set1_epi32( (int)ms );
+const __m256i limit = _mm256_set1_epi32( (int)( overdue ^ 0x80000000 ) );
+__m256i next, status, late, run;
+
+for( ; i + 8 <= (int)_FORE_TASKS; i += 8 )
+   {
+   next = _mm256_i32gather_epi32( (const int *)&taskTable[ i ].next, index, 4 );
+   status = _mm256_i32gather_epi32( &taskTable[ i ].status, index, 4 );
+   // unsigned ( ms - next ) > overdue done as signed compare with sign flipped
+   late = _mm256_cmpgt_epi32( _mm256_xor_si256( _mm256_sub_epi32( now, next ), sign ), limit );
+   run = _mm256_cmpgt_epi32( status, zero );
+   enabledMask[ i >> 5 ] |= (uint32_t)_mm256_movemask_ps( _mm256_castsi256_ps( run ) ) << ( i & 31 );
+   run = _mm256_andnot_si256( late, run );
+   dueMask[ i >> 5 ] |= (uint32_t)_mm256_movemask_ps( _mm256_castsi256_ps( run ) ) << ( i & 31 );
+   }
+#elif defined( _DUE_SSE2 )
+const __m128i sign = _mm_set1_epi32( (int)0x80000000 );
+const __m128i zero = _mm_setzero_si128( );
+const __m128i now = _mm_set1_epi32( (int)ms );
+const __m128i limit = _mm_set1_epi32( (int)( overdue ^ 0x80000000 ) );
+__m128i next, status, late, run;
+
+for( ; i + 4 <= (int)_FORE_TASKS; i += 4 )
+   {
+   next = _mm_setr_epi32( (int)taskTable[ i ].next, (int)taskTable[ i + 1 ].next,
+                          (int)taskTable[ i + 2 ].next, (int)taskTable[ i + 3 ].next );
+   status = _mm_setr_epi32( taskTable[ i ].status, taskTable[ i + 1 ].status,
+                            taskTable[ i + 2 ].status, taskTable[ i + 3 ].status );
+   late = _mm_cmpgt_epi32( _mm_xor_si128( _mm_sub_epi32( now, next ), sign ), limit );
+   run = _mm_cmpgt_epi32( status, zero );
+   enabledMask[ i >> 5 ] |= (uint32_t)_mm_movemask_ps( _mm_castsi128_ps( run ) ) << ( i & 31 );
+   run = _mm_andnot_si128( late, run );
+   dueMask[ i >> 5 ] |= (uint32_t)_mm_movemask_ps( _mm_castsi128_ps( run ) ) << ( i & 31 );
+   }
+#endif
+for( ; i < (int)_FORE_TASKS; i++ )
+   {
+   on = ( taskTable[ i ].status > 0 );
+   due = on & ( _LATE( i, ms ) <= overdue );
+   enabledMask[ i >> 5 ] |= on << ( i & 31 );
+   dueMask[ i >> 5 ] |= due << ( i & 31 );
+   }
+#ifdef ENABLE_GROUPS
+for( i = 0; i < (int)_MASK_WORDS; i++ )
+   dueMask[ i ] &= ~suspendMask[ i ];   // held tasks not run
+#endif
+}
+
+
+/* runDueMask - ONE pass of task table using bitmask of due tasks
+   Builds masks then runs only tasks with bits set, lowest ID first so order
+   is still list of tasks. Tasks enabled but not due get executed cleared.
+   Due time of each task is checked again before running, as a task earlier
+   in the pass may have moved it on (setInterval), so same tasks run as with
+   runList.
+
+   Parameters  unsigned long pass start time in ms
+               unsigned int  time since last pass in ms
+               int           task ID to start from, 0 new pass (masks built)
+
+   Returns     int Number of tasks executed
+*/
+int runDueMask( unsigned long ms, unsigned int overdue, int first )
+{
+int i, done;
+uint32_t bits;
+
+if( first == 0 )
+  buildDueMask( ms, overdue );
+done = 0;
+for( i = first >> 5; i < (int)_MASK_WORDS; i++ )
+   {
+   bits = enabledMask[ i ] & ~dueMask[ i ];
+   while( bits )
+     {
+     taskTable[ i * 32 + __builtin_ctz( bits ) ].executed = 0;   // not run
+     bits &= bits - 1;
+     }
+   bits = dueMask[ i ];
+   if( i == first >> 5 )
+     bits &= (uint32_t)0xFFFFFFFF << ( first & 31 );   // already done
+   while( bits )
+     {
+     running = i * 32 + __builtin_ctz( bits );
+     bits &= bits - 1;
+     if( _LATE( running, ms ) > overdue )   // moved on since mask built
+       {
+       taskTable[ running ].executed = 0;   // not run
+       continue;
+       }
+     runTask( running, ms );
+     done++;
+#ifdef ENABLE_PASS_BUDGET
+     if( micros( ) - callStart >= PASS_BUDGET && running + 1 < (int)_FORE_TASKS )
+       {
+       resumeID = running + 1;              // rest of pass on next call
+       running = (int)_MAX_TASKS;
+       return done;
+       }
+#endif
+     }
+   }
+running = (int)_MAX_TASKS;
+return done;
+}
+#endif
+
+
+#ifdef ENABLE_LINKS
+/* runLinks - Run consumers made pending by their producers this pass
+   Consumers are run in topological order (worked out at Init) so a consumer
+   that is also a producer makes its own consumers pending before they are
+   reached, whole chain runs in the same pass. Consumers must be started,
+   ones that already ran since being made pending are not run again.
+
+   Parameters  unsigned long pass start time in ms
+
+   Returns     int Number of tasks executed
+*/
+int runLinks( unsigned long ms )
+{
+int i, done;
+
+done = 0;
+for( i = 0; i < linkQty; i++ )
+   {
+   running = linkOrder[ i ];
+   if( linkPending[ running ] )
+     {
+     linkPending[ running ] = 0;
+     if( taskTable[ running ].status > 0 && !_SUSPENDED( running ) )
+       {
+       runTask( running, ms );
+       done++;
+       }
+     }
+   }
+running = (int)_MAX_TASKS;
+return done;
+}
+
+
+/* linkInit - Check task links and work out order to run consumers
+   Returns  int -3 invalid task ID in a link
+                -2 links form a loop
+                 1 OK
+*/
+int linkInit( )
+{
+int i, j, placed, more;
+
+for( i = 0; i < (int)_MAX_TASKS; i++ )
+   {
+   linkProducer[ i ] = 0;
+   linkPending[ i ] = 0;
+   linkDepth[ i ] = 0;
+   }
+for( i = 0; i < (int)_LINKS; i++ )
+   {
+   if( taskLinks[ i ][ 0 ] < 0 || taskLinks[ i ][ 0 ] >= (int)_MAX_TASKS
+       || taskLinks[ i ][ 1 ] < 0 || taskLinks[ i ][ 1 ] >= (int)_MAX_TASKS )
+     return -3;
+   linkProducer[ taskLinks[ i ][ 0 ] ] = 1;
+   linkDepth[ taskLinks[ i ][ 1 ] ]++;
+   }
+/* Topological sort, repeatedly place tasks with all producers placed in list
+   order, consumers go into linkOrder as placed */
+linkQty = 0;
+placed = 0;
+do {
+   more = 0;
+   for( i = 0; i < (int)_MAX_TASKS; i++ )
+      if( linkDepth[ i ] == 0 )
+        {
+        linkDepth[ i ] = -1;            // placed
+        placed++;
+        more = 1;
+        for( j = 0; j < (int)_LINKS; j++ )
+           if( taskLinks[ j ][ 0 ] == i )
+             {
+             if( --linkDepth[ taskLinks[ j ][ 1 ] ] == 0 )
+               linkOrder[ linkQty++ ] = taskLinks[ j ][ 1 ];
+             }
+        }
+   } while( more );
+return placed == (int)_MAX_TASKS ? 1 : -2;
+}
+#endif
+
+
+#ifdef ENABLE_CYCLIC
+/* runFrame - ONE minor frame of cyclic executive
+   Runs started tasks listed for this frame in cyclicTasks (from Tasklist.h)
+   in order, without looking at due times, then moves on to next frame. So
+   every pass does the same steps whenever it is run, tasks not in the frame
+   are not looked at.
+
+   Parameters  unsigned long pass start time in ms
+
+   Returns     int Number of tasks executed
+*/
+int runFrame( unsigned long ms )
+{
+unsigned int i;
+int done;
+
+if( !cyclicValid )                  // Init found bad tables
+  return 0;
+// only tasks of last frame can have executed set
+for( i = cyclicFrame[ lastFrame ]; i < cyclicFrame[ lastFrame + 1 ]; i++ )
+   taskTable[ cyclicTasks[ i ] ].executed = 0;
+done = 0;
+for( i = cyclicFrame[ frame ]; i < cyclicFrame[ frame + 1 ]; i++ )
+   {
+   running = cyclicTasks[ i ];
+   if( taskTable[ running ].status > 0 && !_SUSPENDED( running ) )
+     {
+     runTask( running, ms );
+     done++;
+     }
+   }
+running = (int)_MAX_TASKS;
+lastFrame = frame;
+if( ++frame >= CYCLIC_FRAMES )
+  frame = 0;
+return done;
+}
+
+
+/* cyclicInit - Check cyclicFrame and cyclicTasks tables from Tasklist.h
+   Frame starts must not go backwards or past end of cyclicTasks and every
+   entry of cyclicTasks must be a task in the list
+
+   Returns  int -3 invalid task ID or frame start
+                 1 OK
+*/
+int cyclicInit( )
+{
+unsigned int i;
+
+cyclicValid = 0;
+for( i = 0; i < CYCLIC_FRAMES; i++ )
+   if( cyclicFrame[ i ] > cyclicFrame[ i + 1 ] )
+     return -3;
+if( cyclicFrame[ CYCLIC_FRAMES ] > sizeof( cyclicTasks ) / sizeof( cyclicTasks[ 0 ] ) )
+  return -3;
+for( i = cyclicFrame[ 0 ]; i < cyclicFrame[ CYCLIC_FRAMES ]; i++ )
+   if( cyclicTasks[ i ] >= _MAX_TASKS )
+     return -3;
+cyclicValid = 1;
+return 1;
+}
+#endif
+
+
+#ifdef ENABLE_DEGRADE
+/* degradeCheck - Overload control at end of each pass
+   When overloaded (overdue average DEGRADE_HIGH ms or more, or pass as long as
+   MIN_TASK_INTERVAL) stretch interval of lowest priority degradable task (last
+   in list) not already at its highest level. When load is low again
+   (overdue average DEGRADE_LOW ms or less and pass under half of
+   MIN_TASK_INTERVAL) restore highest priority degraded task first. After
+   each change waits DEGRADE_HOLD passes for rolling average to catch up.
+   New level is used from each task's next run.
+
+   Parameters  unsigned long pass time in ms
+*/
+void degradeCheck( unsigned long pass )
+{
+int i;
+
+if( degradeHold > 0 )
+  {
+  degradeHold--;
+  return;
+  }
+if( stats.overdueAvg >= DEGRADE_HIGH || pass >= MIN_TASK_INTERVAL )
+  {
+  for( i = (int)_MAX_TASKS - 1; i >= 0; i-- )
+     if( degradeLevel[ i ] < degradeMax[ i ] )
+       {
+       if( degradeLevel[ i ]++ == 0 )
+         stats.degraded++;
+       stats.degrades++;
+       degradeHold = DEGRADE_HOLD;
+       return;
+       }
+  }
+else
+  if( stats.overdueAvg <= DEGRADE_LOW && pass < MIN_TASK_INTERVAL / 2 )
+    for( i = 0; i < (int)_MAX_TASKS; i++ )
+       if( degradeLevel[ i ] )
+         {
+         if( --degradeLevel[ i ] == 0 )
+           stats.degraded--;
+         stats.restores++;
+         degradeHold = DEGRADE_HOLD;
+         return;
+         }
+}
+#endif
+
+
+/* triggerApply - Make tasks Triggered since last pass due this pass
+   Tasks that are not started (or were stopped since) are left as they are
+*/
+void triggerApply( )
+{
+int i;
+
+for( i = 0; i < (int)_MAX_TASKS; i++ )
+   if( triggerPending[ i ] )
+     {
+     triggerPending[ i ] = 0;
+     if( taskTable[ i ].status > 0 )
+       taskTable[ i ].next = old_ms;    // due this pass
+     }
+}
 
 
 /* Run - Task scheduling loop
@@ -123,6 +1300,42 @@ unsigned int overdueAvg[ _MAX_AVERAGE ];
 
    Order of task execution is list of tasks
 
+   If any task has been made due by Trigger the pass is done straight away
+   without waiting for MIN_TASK_INTERVAL, Triggered tasks are made due at its
+   start (see triggerApply).
+
+   With ENABLE_TIMERS any expired software timers are processed first.
+
+   With ENABLE_GROUPS group changes asked for since last pass (including by
+   timers) are applied next, before any task is run, see groupApply. Tasks
+   held by groupSuspend are not run.
+
+   With ENABLE_BACKGROUND the last BACKGROUND_TASKS in the list are only run
+   after the pass, in spare time before the next task is due.
+
+   With ENABLE_PASS_BUDGET when a call has taken more than PASS_BUDGET us after
+   running a task Run returns, the next call carries on with the rest of the
+   pass before any new pass. As a pass is always finished before the next one
+   starts tasks at the end of list are never left out. At least one task is
+   run on each call. The end of pass steps below are done when pass finishes.
+
+   With ENABLE_DUE_MASK the due tasks for whole table are found first as a
+   bitmask then only those are run, still in order of list.
+
+   With ENABLE_LINKS consumers of tasks that completed with link status are
+   run in the same pass after the list, see runLinks.
+
+   With ENABLE_DEGRADE overload is checked at end of each pass and intervals
+   of degradable tasks stretched or restored, see degradeCheck.
+
+   With ENABLE_ADAPTIVE_TICK pass is not done every MIN_TASK_INTERVAL but when
+   next task or timer is due (between TICK_MIN and TICK_MAX, see tickUpdate),
+   overdue is then how late Run was called after that time.
+
+   With ENABLE_CYCLIC each pass runs the started tasks of the next minor frame
+   from the cyclicFrame and cyclicTasks tables, intervals are not used. A late
+   pass runs the frame late, frames are never skipped.
+
    When task has completed -
         updates task status with status returned,
         adjusts next run time using interval specified.
@@ -139,6 +1352,14 @@ unsigned int overdueAvg[ _MAX_AVERAGE ];
       rolling average overdue (16 point rolling average)
 
    Then copy tasks table and statistics to copies for User application analysis
+   (and with ENABLE_LINUX_SHM to shared memory for other programs, with
+   ENABLE_TELEMETRY changes sent as telemetry frames)
+
+   With ENABLE_LINUX_WATCHDOG each call and task run is seen by monitor
+   thread, see ScheduleWatch.cpp.
+
+   Instrumentation hooks SCHEDULE_BEFORE_TASK and SCHEDULE_AFTER_TASK are
+   used around every task run and SCHEDULE_END_PASS at end of each pass.
 
    Parameters - NONE
 
@@ -149,59 +1370,159 @@ unsigned int overdueAvg[ _MAX_AVERAGE ];
 int Run()
 {
 int done;
+#ifndef ENABLE_CYCLIC
+int first;
+#endif
 unsigned int overdue;
 unsigned long ms;
-unsigned long last_us;
+#ifdef ENABLE_USAGE
+unsigned long pass_us;
+#endif
+#ifdef ENABLE_CYCLE_CLOCK
+unsigned long loopStart;
+#endif
 
 // get current time exit if too early
 ms = millis( );
-overdue = (unsigned int)( ms - old_ms );
-if( overdue < MIN_TASK_INTERVAL )
-  return -1;
+#ifdef SCHEDULE_TASK
+if( passForced )
+  ms = passMs;                      // same time steps as parent
+#endif
+#ifdef ENABLE_CYCLE_CLOCK
+loopStart = CLOCK_NOW( );
+#endif
+#ifdef ENABLE_USAGE
+pass_us = CLOCK_NOW( );             // all of call is scheduler time
+#endif
+#ifdef _WATCH
+watchThread = pthread_self( );
+watchBeat++;                        // Run is being called
+#endif
+#ifndef ENABLE_CYCLIC
+first = 0;
+#endif
+#ifdef ENABLE_PASS_BUDGET
+callStart = micros( );
+callMs = ms;
+first = resumeID;
+resumeID = 0;
+if( first )
+  { // finish pass that ran out of time on last call first
+  ms = old_ms;
+  overdue = passOverdue;
+  }
+else
+#endif
+  {
+  overdue = (unsigned int)( ms - old_ms );
+#if defined( ENABLE_CYCLIC )
+  if( overdue < MIN_TASK_INTERVAL && !_FORCED )
+    {
+#ifdef ENABLE_USAGE
+    usageUpdate( pass_us );         // calls with nothing to do count too
+#endif
+    return -1;
+    }
+#elif defined( ENABLE_ADAPTIVE_TICK )
+  if( (long)( ms - nextCheck ) < 0 )
+    {
+    if( !triggered )
+      {
+#ifdef ENABLE_USAGE
+      usageUpdate( pass_us );       // calls with nothing to do count too
+#endif
+      return -1;
+      }
+    tickLate = 0;
+    }
+  else
+    tickLate = (unsigned int)( ms - nextCheck );
+#else
+  if( overdue < MIN_TASK_INTERVAL && !triggered && !_FORCED )
+    {
+#ifdef ENABLE_USAGE
+    usageUpdate( pass_us );         // calls with nothing to do count too
+#endif
+    return -1;
+    }
+#endif
 
-old_ms = ms;
+  old_ms = ms;
+  if( triggered )
+    {
+    triggered = 0;
+    _BARRIER( );                    // flag cleared before pending read
+    triggerApply( );
+    }
+#ifdef ENABLE_TIMERS
+  runTimers( ms );
+#endif
+#ifdef ENABLE_GROUPS
+  if( groupPending )
+    groupApply( );
+#endif
+  }
 
 // Do schedule list ONE pass
-done = 0;
-for( running = 0; running < (int)_MAX_TASKS; running++ )
-   {
-   if( taskTable[ running ].status > 0 )      // task enabled
-     { // check if time to run as in correct interval or overdue
-     if( ms - taskTable[ running ].next <= overdue )
-       { // run task get new status
-       last_us = micros( );
-       taskTable[ running ].status = ( *tasks[ running ])( running, taskTable[ running ].status );
-       last_us = micros( ) - last_us;
-       if( taskTable[ running ].status > 0 )    // process based on new status
-         taskTable[ running ].next = ms + taskTable[ running ].interval;
-       // save execution time
-       taskTable[ running ].last = last_us;
-       taskTable[ running ].executed = 1;       // Ran
+#if defined( ENABLE_CYCLIC )
+done = runFrame( ms );
+#elif defined( ENABLE_DUE_MASK )
+done = runDueMask( ms, overdue, first );
+#else
+done = runList( ms, overdue, first );
+#endif
+#ifdef ENABLE_LINKS
+#ifdef ENABLE_PASS_BUDGET
+if( !resumeID )                     // only when pass is finished
+#endif
+  done += runLinks( ms );
+#endif
+#ifdef ENABLE_PASS_BUDGET
+passDone += done;
+if( resumeID )
+  { // out of time return to caller leaving rest of pass
+  passOverdue = overdue;
 #ifndef DISABLE_STATS
-       if( last_us > stats.maxExec )        // check if above max execution
-         {
-         stats.maxExec = last_us;           // save max execution time
-         stats.maxID = running;             // and task ID
-         }
+  if( first == 0 )
+    stats.budgetHits++;             // count passes split
+#ifdef ENABLE_CYCLE_CLOCK
+  ms = CLOCK_ELAPSED( loopStart );
+#else
+  ms = millis( ) - callMs;
+#endif
+  if( ms > stats.maxLoop )
+    stats.maxLoop = ms;
+#endif
+#ifdef ENABLE_USAGE
+  usageUpdate( pass_us );
+#endif
+  return done;
+  }
+done = passDone;
+passDone = 0;
 #endif
-       done++;
-       }
-     else
-       taskTable[ running ].executed = 0;   // not run
-     }
-   }
 #ifndef DISABLE_STATS
 /* End of pass create statistics */
 stats.finish = millis( );           // pass end time
 stats.start = ms;                   // pass start time
+#if defined( ENABLE_CYCLE_CLOCK )
+ms = CLOCK_ELAPSED( loopStart );    // get loop time of this call (ns)
+#elif defined( ENABLE_PASS_BUDGET )
+ms = stats.finish - callMs;         // get loop time of this call
+#else
 ms = stats.finish -  stats.start;   // get loop time
+#endif
 if( ms > stats.maxLoop )
   stats.maxLoop = ms;               // save longest loop time
 stats.qty = done;                   // number of tasks run this pass
+#ifdef ENABLE_ADAPTIVE_TICK
+overdue = tickLate;                 // late after time pass was due
+#else
 if( overdue <= MIN_TASK_INTERVAL )  // Only add to stats if really overdue
   overdue = 0;
 else
   overdue -= MIN_TASK_INTERVAL;
+#endif
 stats.overdue = overdue;            // how late scheduler was called
 if( overdue > stats.overdueMax )
   stats.overdueMax = overdue;       // Max Overdue call to scheduling
@@ -212,6 +1533,15 @@ overdueAvg[ overdueIdx ] = overdue;
 if( ++overdueIdx >= _MAX_AVERAGE )
   overdueIdx = 0;
 #endif
+#ifdef ENABLE_DEGRADE
+degradeCheck( stats.finish - stats.start );
+#endif
+#ifdef ENABLE_ADAPTIVE_TICK
+tickUpdate( );
+#endif
+#ifdef ENABLE_BACKGROUND
+done += runBackground( );
+#endif
 // Snapshot copy tables and stats for any requests
 #ifndef DISABLE_LOGGING
 memcpy( tasksCopy, taskTable, sizeof( taskTable ) );
@@ -219,10 +1549,101 @@ memcpy( tasksCopy, taskTable, sizeof( taskTable ) );
 #ifndef DISABLE_STATS
 memcpy( &statsCopy, &stats, sizeof( struct Stats ) );
 #endif
+#ifdef ENABLE_LINUX_SHM
+shmPublish( );
+#endif
+#ifdef ENABLE_TELEMETRY
+telePublish( );
+#endif
+SCHEDULE_END_PASS( done );
+#ifdef ENABLE_USAGE
+usageUpdate( pass_us );
+#endif
 return done;
 }
 
 
+#ifdef ENABLE_STAGGER
+/* staggerAdd - Add or remove a task from load of window
+   Uses passes between runs saved when task was added (staggerTicks), so
+   a task is taken out of the same slots even if its interval has changed
+
+   Parameters  int Task ID
+               int 1 add, -1 remove
+*/
+void staggerAdd( int ID, int add )
+{
+int i;
+
+for( i = 0; i < STAGGER_SLOTS; i += staggerTicks[ ID ] )
+   staggerLoad[ ( staggerSlot[ ID ] + i ) % STAGGER_SLOTS ] += add;
+}
+
+
+/* staggerStop - Take a task out of load of window when it stops
+   (status 0 or less) so its passes are free for tasks started later
+
+   Parameters  int Task ID
+*/
+void staggerStop( int ID )
+{
+if( staggerSlot[ ID ] >= 0 )
+  staggerAdd( ID, -1 );
+staggerSlot[ ID ] = -1;
+}
+
+
+/* staggerNext - Work out phase of a task being started and its first run
+   Of each possible pass for first run within one interval, picks one where
+   the task adds least to the busiest pass of window (then least in total),
+   preferring latest (a full interval as without staggering). Task phase is
+   how much earlier than a full interval it first runs.
+
+   Parameters  int Task ID
+               unsigned long time task started (ms)
+
+   Returns     unsigned long time of first run (ms)
+*/
+unsigned long staggerNext( int ID, unsigned long ms )
+{
+int i, t, best, ticks, now;
+unsigned int load, sum, bestLoad, bestSum, due;
+
+staggerStop( ID );                      // take out old place
+taskTable[ ID ].phase = 0;
+ticks = taskTable[ ID ].interval / MIN_TASK_INTERVAL;
+if( ticks < 1 )
+  return ms + taskTable[ ID ].interval;
+
+now = (int)( ( ( ms - staggerBase ) / MIN_TASK_INTERVAL ) % STAGGER_SLOTS );
+best = ticks;
+bestLoad = bestSum = ~0U;
+for( t = ticks; t >= 1 && t > ticks - STAGGER_SLOTS; t-- )
+   {
+   load = sum = 0;
+   for( i = 0; i < STAGGER_SLOTS; i += ticks )
+      {
+      due = staggerLoad[ ( now + t + i ) % STAGGER_SLOTS ];
+      sum += due;
+      if( due > load )
+        load = due;
+      }
+   if( load < bestLoad || ( load == bestLoad && sum < bestSum ) )
+     {
+     best = t;
+     bestLoad = load;
+     bestSum = sum;
+     }
+   }
+staggerSlot[ ID ] = ( now + best ) % STAGGER_SLOTS;
+staggerTicks[ ID ] = ticks;
+staggerAdd( ID, 1 );
+taskTable[ ID ].phase = ( ticks - best ) * MIN_TASK_INTERVAL;
+return ms + taskTable[ ID ].interval - taskTable[ ID ].phase;
+}
+#endif
+
+
 /* Init - Initialise all Tasks in scheduling table
    Calls each task with a status of 0 to initialise, each task must initialise
       own status and variables
@@ -236,30 +1657,76 @@ return done;
    internal variables and following init calls to just set interval and status
    for THIS task.
 
+   With ENABLE_STAGGER first run of each task is set up to a whole interval
+   earlier so tasks with same or harmonic intervals are spread over different
+   passes, see staggerNext.
+
+   With ENABLE_LINKS task links are checked first, on error no task is
+   initialised so nothing will run. With ENABLE_CYCLIC the frame tables are
+   checked the same way.
+
    Parameters - NONE
 
-   Returns  int < 0 Error no tasks in list
+   Returns  int -3  Invalid task ID in taskLinks or cyclicTasks (or frame
+                    start in cyclicFrame)
+                -2  taskLinks form a loop
+                < 0 Error no tasks in list
                 > 0 Number of tasks executed
 */
 int Init( )
 {
 unsigned long ms;
 unsigned long last_us;
+int status;
+#if defined( ENABLE_LINKS ) || defined( ENABLE_CYCLIC )
+int i;
+#endif
+
+#ifdef ENABLE_LINKS
+if( ( i = linkInit( ) ) < 0 )
+  return i;
+#endif
+#ifdef ENABLE_CYCLIC
+if( ( i = cyclicInit( ) ) < 0 )
+  return i;
+#endif
 
 // get current time
 ms = millis( );
 old_ms = ms;        // Save last executed as now
+#ifdef ENABLE_ADAPTIVE_TICK
+nextCheck = ms + TICK_MIN;
+#endif
+#ifdef ENABLE_CYCLE_CLOCK
+clockInit( );
+#endif
+#ifdef ENABLE_USAGE
+sampleStart = CLOCK_NOW( );
+#endif
+#ifdef ENABLE_STAGGER
+staggerBase = ms;
+for( running = 0; running < (int)_MAX_TASKS; running++ )
+   staggerSlot[ running ] = -1;
+#endif
 
 for( running = 0; running < (int)_MAX_TASKS; running++ )
    {
-   last_us = micros( );
-   taskTable[ running ].status = (*tasks[ running ])( running, 0 );
-   last_us = micros( ) - last_us;
-   taskTable[ running ].last = last_us;   // save execution time
+   last_us = CLOCK_NOW( );
+   status = (*tasks[ running ])( running, 0 );
+   last_us = CLOCK_ELAPSED( last_us );
+   taskTable[ running ].status = _STATUS( status );
+   taskTable[ running ].last = _LAST( last_us );  // save execution time
    taskTable[ running ].executed = 1;     // Ran
    if( taskTable[ running ].status > 0 )
+#ifdef ENABLE_STAGGER
+     taskTable[ running ].next = staggerNext( running, ms );
+#else
      taskTable[ running ].next = ms + taskTable[ running ].interval;
+#endif
    }
+#ifndef DISABLE_LOGGING
+memcpy( tasksCopy, taskTable, sizeof( taskTable ) );
+#endif
 return running;
 }
 
@@ -267,21 +1734,70 @@ return running;
 /* checkID - Common ID check for valid and not running
     Parameters  int Task ID to check
 
-    Return int  -1  invalid ID
-                 0  current task running
-                 1  Valid
+    Return int  -1  invalid ID
+                 0  current task running
+                 1  Valid
+*/
+int checkID( int ID )
+{
+if( ID < 0 || ID >= (int)_MAX_TASKS )
+  return -1;
+if( ID == running )
+  return 0;
+return 1;
+}
+
+
+#ifdef ENABLE_COMPACT
+/* taskNext - Full next execution time of task from low 16 bits kept
+   Next is always within 32767 ms of last pass time
+
+   Parameters  int Task ID
+
+   Returns     unsigned long next execution time in ms
+*/
+unsigned long taskNext( int ID )
+{
+return old_ms + _UNTIL( ID, old_ms );
+}
+#endif
+
+
+#ifndef DISABLE_LOGGING
+/* LogTask - Get one task from snapshot at full width
+   With ENABLE_COMPACT table entries are packed so this is the way to see
+   full next time, otherwise same as entry from Log
+
+   Parameters  int Task ID
+
+   Return      Pointer to task details (same structure used each call)
+               NULL invalid ID
+               See Tasklist.h for details of structure for accessing
 */
-int checkID( int ID )
+struct TaskView *LogTask( int ID )
 {
+static struct TaskView view;
+
 if( ID < 0 || ID >= (int)_MAX_TASKS )
-  return -1;
-if( ID == running )
-  return 0;
-return 1;
+  return NULL;
+#ifdef ENABLE_COMPACT
+view.next = old_ms + (long)(short)( tasksCopy[ ID ].next - (unsigned short)old_ms );
+#else
+view.next = tasksCopy[ ID ].next;
+#endif
+view.last = tasksCopy[ ID ].last;
+view.status = tasksCopy[ ID ].status;
+view.interval = tasksCopy[ ID ].interval;
+view.executed = tasksCopy[ ID ].executed;
+#ifdef ENABLE_STAGGER
+view.phase = tasksCopy[ ID ].phase;
+#else
+view.phase = 0;
+#endif
+return &view;
 }
 
 
-#ifndef DISABLE_LOGGING
 /* Log - Take snapshot of all tasks - task scheduling details
    Copies current tasksTable to tasksCopy and returns pointer to tasksCopy
 
@@ -291,6 +1807,10 @@ return 1;
                See Schedule.h for details of structure for accessing
 
                Array is _MAX_TASKS long so remember to define it
+               With ENABLE_STAGGER phase is how many ms earlier than a
+               whole interval the task was first run after Init or Start
+               With ENABLE_COMPACT entries are packed, use LogTask to see
+               a task at full width
 */
 struct TaskList *Log( )
 {
@@ -315,16 +1835,84 @@ stats.overdueMax = 0;
 stats.maxExec = 0;
 stats.maxID = 0;
 stats.maxLoop = 0;
+#ifdef ENABLE_PASS_BUDGET
+stats.budgetHits = 0;
+#endif
+#ifdef ENABLE_LINUX_RT
+stats.wakeMax = 0;
+#endif
 return &statsCopy;
 }
 #endif
 
 
+#ifdef ENABLE_USAGE
+/* getUsage - Get CPU use of each task and scheduler
+   Copy is updated every USAGE_SAMPLE ms
+
+   Parameters  None
+
+   Return      Pointer to copy array of CPU use structures _MAX_TASKS + 1 long
+               index is task ID, last entry (index _MAX_TASKS) is scheduler
+               itself (time in Run not in tasks).
+               See Tasklist.h for details of structure for accessing
+*/
+struct Usage *getUsage( )
+{
+return usageCopy;
+}
+#endif
+
+
+#ifdef ENABLE_PROFILE
+/* getProfile - Get run times of a task in one state
+   Entries are in order each task and state was first seen, to list all
+   call with index 0, 1, 2... until NULL. Entries are live so read between
+   calls of Run.
+
+   Parameters  int index of entry
+
+   Return      Pointer to entry
+               NULL past last entry
+               See Tasklist.h for details of structure for accessing
+*/
+struct Profile *getProfile( int index )
+{
+if( index < 0 || index >= (int)profileQty )
+  return NULL;
+return &profile[ index ];
+}
+
+
+/* clearProfile - Remove all entries to start profiling again
+   Parameters  None
+
+   Return      unsigned long runs not counted since last clear as table full
+*/
+unsigned long clearProfile( )
+{
+unsigned long dropped;
+
+memset( profileHash, 0, sizeof( profileHash ) );
+profileQty = 0;
+dropped = profileDropped;
+profileDropped = 0;
+return dropped;
+}
+#endif
+
+
 /* setInterval - set the interval time in ms for a task
    If task running just sets interval as next execution will be set at task end.
 
    When task NOT running, also sets next execution time to now plus interval.
 
+   Smallest interval is MIN_TASK_INTERVAL, or TICK_MIN with
+   ENABLE_ADAPTIVE_TICK. Largest with ENABLE_COMPACT is 32767.
+
+   With ENABLE_GROUPS interval used is scaled by groupScale of groups of
+   the task, getInterval still returns interval set here.
+
     Parameters  int Task ID to check
                 int interval to set
 
@@ -339,12 +1927,28 @@ int i;
 
 if( ( i = checkID( ID ) ) < 0 )
   return i;
+#ifdef ENABLE_ADAPTIVE_TICK
+if( interval < TICK_MIN )
+#else
 if( interval < MIN_TASK_INTERVAL )
+#endif
   return -2;
+#ifdef ENABLE_COMPACT
+if( interval > _MAX_INTERVAL )      // must fit in 15 bits
+  return -2;
+#endif
+#ifdef ENABLE_GROUPS
+baseInterval[ ID ] = interval;
+interval = groupInterval( ID );
+#endif
 taskTable[ ID ].interval = interval;
 if( i != 0 )
   {
   taskTable[ ID ].next = millis( ) + interval;
+#ifdef ENABLE_ADAPTIVE_TICK
+  if( _UNTIL( ID, nextCheck ) < 0 )
+    nextCheck += _UNTIL( ID, nextCheck );
+#endif
   return 1;
   }
 return 0;
@@ -352,6 +1956,8 @@ return 0;
 
 
 /* getInterval - get the interval time in ms for a task
+   With ENABLE_GROUPS interval last set, before any groupScale
+
     Parameters  int Task ID to check
 
     Return int  < 0 invalid ID
@@ -363,7 +1969,11 @@ int i;
 
 if( ( i = checkID( ID ) ) < 0 )
   return i;
+#ifdef ENABLE_GROUPS
+return baseInterval[ ID ];
+#else
 return taskTable[ ID ].interval;
+#endif
 }
 
 
@@ -375,7 +1985,7 @@ return taskTable[ ID ].interval;
     Parameters  int Task ID to check
 
     Return      unsigned long of time (or could be errors)
-                0 could be execution time or errro of invalid ID
+                0 could be execution time or error of invalid ID
                 1 could be execution time or error of NO interval check
 */
 unsigned long getTime( int ID )
@@ -386,7 +1996,11 @@ if( ( i = checkID( ID ) ) < 0 )
   return 0;
 if( taskTable[ ID ].interval <= 0 )
   return 1;
+#ifdef ENABLE_COMPACT
+return taskNext( ID );
+#else
 return taskTable[ ID ].next;
+#endif
 }
 
 
@@ -407,12 +2021,33 @@ return taskTable[ ID ].status;
 }
 
 
+/* startTask - Set task started and its first run one interval from last pass
+   Parameters  int Task ID already checked
+*/
+void startTask( int ID )
+{
+taskTable[ ID ].status = 1;
+#ifdef ENABLE_STAGGER
+taskTable[ ID ].next = staggerNext( ID, old_ms );
+#else
+taskTable[ ID ].next = old_ms + taskTable[ ID ].interval;
+#endif
+#ifdef ENABLE_ADAPTIVE_TICK
+if( _UNTIL( ID, nextCheck ) < 0 )
+  nextCheck += _UNTIL( ID, nextCheck );
+#endif
+}
+
+
 /* Start - Start a task if not running and has interval set
    Cannot start an already started task
 
    It is responsibility of the task to stop its task and any associated
    resources (GPIO/TWI/SPI etc).
 
+   With ENABLE_STAGGER first run is set by staggerNext like Init does (this
+   checks up to STAGGER_SLOTS passes so takes longer from interrupts)
+
     Parameters  int Task ID to start
 
     Return int  -3  Task already started
@@ -432,9 +2067,7 @@ if( taskTable[ ID ].interval <= 0 )
   return -2;
 if( taskTable[ ID ].status  > 0 )
   return -3;
-// Start task
-taskTable[ ID ].status = 1;
-taskTable[ ID ].next = old_ms + taskTable[ ID ].interval;
+startTask( ID );
 return 1;
 }
 
@@ -462,3 +2095,537 @@ if( i == (int)_MAX_TASKS )
   return -2;
 return i;
 }
+
+
+/* Trigger - Make a started task due now
+   For events like data ready or messages waiting, the task is run on the next
+   call of Run without waiting for its interval or MIN_TASK_INTERVAL. After
+   running its next time is set from its interval as normal.
+
+   Can be used from interrupts, other threads or tasks. Only sets a pending
+   byte and flag, the task is made due at the start of the next pass so the
+   task table is never written from interrupts. Triggering the task that is
+   running (or from a task earlier in the list) runs it again next pass.
+
+   With ENABLE_LINUX_RT, Trigger from another thread also wakes the
+   scheduler thread (see rtWake) so the next call of Run is straight away
+   rather than when its sleep ends.
+
+   Not available with ENABLE_CYCLIC as tasks only run in their frames.
+
+    Parameters  int Task ID to make due
+
+    Return int  -3  ENABLE_CYCLIC
+                -2  Task not started or held by groupSuspend (nothing done)
+                -1  invalid ID
+                 1  Task will run on next call of Run
+*/
+int Trigger( int ID )
+{
+#ifdef ENABLE_CYCLIC
+(void)ID;
+return -3;
+#else
+if( ID < 0 || ID >= (int)_MAX_TASKS )
+  return -1;
+if( taskTable[ ID ].status <= 0 || _SUSPENDED( ID ) )
+  return -2;
+triggerPending[ ID ] = 1;
+_BARRIER( );                        // pending set before flag
+triggered = 1;
+#ifdef ENABLE_LINUX_RT
+rtWake( );                          // scheduler thread may be asleep
+#endif
+return 1;
+#endif
+}
+
+
+/* getNextRun - Get time when Run next has something to do
+   For hosts or low power use to sleep until then instead of calling Run
+   continuously. Tasks started or changed by interrupts or other threads
+   while asleep can make this earlier.
+
+    Parameters  None
+
+    Return      unsigned long time in ms (as millis)
+*/
+unsigned long getNextRun( )
+{
+unsigned long ms;
+long due;
+
+#ifdef ENABLE_PASS_BUDGET
+if( resumeID )
+  return millis( );                 // rest of pass to do
+#endif
+#ifdef ENABLE_CYCLIC
+return old_ms + MIN_TASK_INTERVAL;  // every frame is a pass
+#endif
+if( triggered )
+  return millis( );
+#ifdef ENABLE_ADAPTIVE_TICK
+return nextCheck;                   // worked out at end of last pass
+#endif
+ms = old_ms + MIN_TASK_INTERVAL;    // earliest next pass
+due = nextDue( ms, _MAX_TASKS );
+if( due > 0 && due != 0x7FFFFFFFL )
+  ms += due;
+return ms;
+}
+
+
+#ifdef ENABLE_GROUPS
+/* groupApply - Apply group changes asked for since last pass
+   Called from Run at start of a new pass so no task sees a group part
+   changed. Changes are worked out 32 tasks at a time from the bitmasks,
+   only tasks with their bit set are visited. Done in order
+
+        stop        started tasks set to status 0
+        start       stopped tasks with an interval started as Start does
+        suspend     tasks held, status and interval kept
+        resume      held tasks let go, next run one interval from now
+        scale       new percent of group, intervals worked out again from
+                    interval set, next run one interval from now
+*/
+void groupApply( )
+{
+int i, g, ID;
+uint32_t bits;
+long interval;
+
+groupPending = 0;
+for( i = 0; i < (int)_GROUP_WORDS; i++ )
+   {
+   bits = pendStop[ i ];
+   pendStop[ i ] = 0;
+   while( bits )
+     {
+     ID = i * 32 + __builtin_ctz( bits );
+     bits &= bits - 1;
+     if( taskTable[ ID ].status > 0 )
+       {
+       taskTable[ ID ].status = 0;
+#ifdef ENABLE_STAGGER
+       staggerStop( ID );
+#endif
+       }
+     }
+   bits = pendStart[ i ];
+   pendStart[ i ] = 0;
+   while( bits )
+     {
+     ID = i * 32 + __builtin_ctz( bits );
+     bits &= bits - 1;
+     if( taskTable[ ID ].status <= 0 && taskTable[ ID ].interval > 0 )
+       startTask( ID );
+     }
+   suspendMask[ i ] |= pendSuspend[ i ];
+   pendSuspend[ i ] = 0;
+   bits = pendResume[ i ] & suspendMask[ i ];
+   suspendMask[ i ] &= ~pendResume[ i ];
+   pendResume[ i ] = 0;
+   while( bits )
+     {
+     ID = i * 32 + __builtin_ctz( bits );
+     bits &= bits - 1;
+     taskTable[ ID ].next = old_ms + taskTable[ ID ].interval;
+#ifdef ENABLE_ADAPTIVE_TICK
+     if( taskTable[ ID ].status > 0 && _UNTIL( ID, nextCheck ) < 0 )
+       nextCheck += _UNTIL( ID, nextCheck );
+#endif
+     }
+   }
+for( g = 0; g < (int)_GROUPS; g++ )
+   if( pendScale[ g ] )
+     {
+     groupPercent[ g ] = pendScale[ g ];
+     for( i = 0; i < (int)_GROUP_WORDS; i++ )
+        {
+        bits = taskGroups[ g ][ i ];
+        while( bits )
+          {
+          ID = i * 32 + __builtin_ctz( bits );
+          bits &= bits - 1;
+          if( baseInterval[ ID ] <= 0 )
+            continue;                   // no interval to scale
+          interval = groupInterval( ID );
+          taskTable[ ID ].interval = interval;
+          taskTable[ ID ].next = old_ms + interval;
+#ifdef ENABLE_ADAPTIVE_TICK
+          if( taskTable[ ID ].status > 0 && _UNTIL( ID, nextCheck ) < 0 )
+            nextCheck += _UNTIL( ID, nextCheck );
+#endif
+          }
+        }
+     pendScale[ g ] = 0;
+     }
+}
+
+
+/* groupInterval - Interval of task scaled by percent of each of its groups
+   Always from interval given to setInterval, so groupScale of 100 gets it
+   back whatever scaling was done before. Kept between smallest interval and
+   32767 ms.
+
+   Parameters  int Task ID
+
+   Returns     long interval to use in ms
+*/
+long groupInterval( int ID )
+{
+long interval;
+int g;
+
+interval = baseInterval[ ID ];
+for( g = 0; g < (int)_GROUPS; g++ )
+   if( groupPercent[ g ]
+       && ( taskGroups[ g ][ ID >> 5 ] & ( (uint32_t)1 << ( ID & 31 ) ) ) )
+     {
+     interval = interval * groupPercent[ g ] / 100;
+     if( interval > 32767 )
+       interval = 32767;
+     }
+#ifdef ENABLE_ADAPTIVE_TICK
+if( interval < TICK_MIN )
+  interval = TICK_MIN;
+#else
+if( interval < MIN_TASK_INTERVAL )
+  interval = MIN_TASK_INTERVAL;
+#endif
+return interval;
+}
+
+
+/* groupMark - Add tasks of a group to one change waiting for next pass and
+   take them out of the opposite change, so last call before the pass wins
+
+   Parameters  int group
+               pointer bitmask to add to
+               pointer bitmask to take out of
+
+   Return int  -1  invalid group
+                1  change waiting for next pass
+*/
+int groupMark( int group, uint32_t *set, uint32_t *clear )
+{
+int i;
+
+if( group < 0 || group >= (int)_GROUPS )
+  return -1;
+for( i = 0; i < (int)_GROUP_WORDS; i++ )
+   {
+   set[ i ] |= taskGroups[ group ][ i ];
+   clear[ i ] &= ~taskGroups[ group ][ i ];
+   }
+groupPending = 1;
+return 1;
+}
+
+
+/* groupStart - Start all tasks of a group at start of next pass
+   Tasks already started or without an interval are left as they are, others
+   are started as by Start. Call from tasks, timers or the loop calling Run,
+   NOT from interrupts or other threads.
+
+    Parameters  int group (index in taskGroups)
+
+    Return int  -1  invalid group
+                 1  tasks start at next pass
+*/
+int groupStart( int group )
+{
+return groupMark( group, pendStart, pendStop );
+}
+
+
+/* groupStop - Stop all tasks of a group at start of next pass
+   Started tasks are set to status 0 as if they returned 0, so none of the
+   group runs in the next pass. Call from tasks, timers or the loop calling
+   Run, NOT from interrupts or other threads.
+
+    Parameters  int group (index in taskGroups)
+
+    Return int  -1  invalid group
+                 1  tasks stop at next pass
+*/
+int groupStop( int group )
+{
+return groupMark( group, pendStop, pendStart );
+}
+
+
+/* groupSuspend - Hold all tasks of a group from start of next pass
+   Held tasks are not run (even when Triggered or linked) but keep their
+   status and interval, unlike stopping. Tasks started while held are not
+   run until let go. Call from tasks, timers or the loop calling Run, NOT
+   from interrupts or other threads.
+
+    Parameters  int group (index in taskGroups)
+
+    Return int  -1  invalid group
+                 1  tasks held from next pass
+*/
+int groupSuspend( int group )
+{
+return groupMark( group, pendSuspend, pendResume );
+}
+
+
+/* groupResume - Let go tasks of a group held by groupSuspend at next pass
+   Each task carries on with the status it had, next run one interval from
+   the pass. Tasks of the group also in another held group are let go too.
+   Call from tasks, timers or the loop calling Run, NOT from interrupts or
+   other threads.
+
+    Parameters  int group (index in taskGroups)
+
+    Return int  -1  invalid group
+                 1  tasks let go at next pass
+*/
+int groupResume( int group )
+{
+return groupMark( group, pendResume, pendSuspend );
+}
+
+
+/* groupScale - Scale intervals of all tasks of a group at next pass
+   Interval used by each task that has one is interval set by setInterval
+   times percent / 100 (200 runs half as often, 50 twice as often), kept
+   between smallest interval and 32767 ms. Percent replaces any earlier
+   percent of the group rather than adding to it, so groupScale( g, 100 )
+   gets back the intervals as set, and intervals set while scaled are
+   scaled too. A task in more than one scaled group uses all their percents.
+   Next run is then one new interval from the pass, as setInterval. Last
+   call before the pass wins. Call from tasks, timers or the loop calling
+   Run, NOT from interrupts or other threads.
+
+    Parameters  int group (index in taskGroups)
+                int percent 1 to 10000
+
+    Return int  -2  invalid percent
+                -1  invalid group
+                 1  intervals scaled at next pass
+*/
+int groupScale( int group, int percent )
+{
+if( group < 0 || group >= (int)_GROUPS )
+  return -1;
+if( percent < 1 || percent > 10000 )
+  return -2;
+pendScale[ group ] = percent;
+groupPending = 1;
+return 1;
+}
+
+
+/* getSuspended - Get if a task is held by groupSuspend
+    Parameters  int Task ID
+
+    Return int  -1  invalid ID
+                 0  not held
+                 1  held
+*/
+int getSuspended( int ID )
+{
+if( ID < 0 || ID >= (int)_MAX_TASKS )
+  return -1;
+return _SUSPENDED( ID ) ? 1 : 0;
+}
+#endif
+
+
+#ifdef ENABLE_DEGRADE
+/* setDegrade - Let a task have its interval stretched when overloaded
+   Degradable tasks have interval used times 2, 4, 8... up to 2 to power of
+   maxLevel when scheduler is overloaded, lowest priority (end of list) first.
+   Interval set and returned by setInterval/getInterval is not changed.
+
+    Parameters  int Task ID
+                int highest level 0 (not degradable) to DEGRADE_MAX
+
+    Return int  -2  invalid level
+                -1  invalid ID
+                 1  set
+*/
+int setDegrade( int ID, int maxLevel )
+{
+if( checkID( ID ) < 0 )
+  return -1;
+if( maxLevel < 0 || maxLevel > DEGRADE_MAX )
+  return -2;
+degradeMax[ ID ] = maxLevel;
+if( degradeLevel[ ID ] > maxLevel )
+  {
+  if( maxLevel == 0 )
+    stats.degraded--;
+  degradeLevel[ ID ] = maxLevel;
+  }
+return 1;
+}
+
+
+/* getDegrade - Get how much a task's interval is stretched
+    Parameters  int Task ID
+
+    Return int  -1  invalid ID
+                 0  not stretched
+                >0  level, interval used is times 2 to power of level
+*/
+int getDegrade( int ID )
+{
+if( checkID( ID ) < 0 )
+  return -1;
+return degradeLevel[ ID ];
+}
+#endif
+
+
+#ifdef ENABLE_TIMERS
+/* timerStart - Start a software timer to call a function after a delay
+   Function is called from Run at the start of the first pass at or after the
+   delay so timing is to MIN_TASK_INTERVAL. Function is defined as
+
+        void function( int timer, int arg )
+
+   Where timer is the timer number and arg the value passed in here.
+
+   Timers are NOT to be started or stopped from interrupts.
+
+    Parameters  function address to call
+                int user value to pass to function
+                int delay in ms
+                int period in ms to repeat every period, 0 for one shot
+
+    Return int  -2  No free timers
+                -1  Invalid parameters
+                >= 0 Timer number (valid until one shot expires or stopped)
+*/
+int timerStart( void ( *callback )( int, int ), int arg, int delay, int period )
+{
+int i;
+
+if( callback == NULL || delay < 0 || period < 0 )
+  return -1;
+if( freeQty )
+  i = timerFree[ --freeQty ];
+else
+  if( timerUsed < MAX_TIMERS )
+    i = timerUsed++;
+  else
+    return -2;
+timers[ i ].expire = millis( ) + delay;
+timers[ i ].period = period;
+timers[ i ].callback = callback;
+timers[ i ].arg = arg;
+timerAdd( i );
+return i;
+}
+
+
+/* timerStop - Stop a software timer
+    Parameters  int timer number
+
+    Return int  -1  Invalid or not active timer
+                 1  Timer stopped
+*/
+int timerStop( int timer )
+{
+if( timer < 0 || timer >= timerUsed || timerPos[ timer ] < 0 )
+  return -1;
+timerRemove( timer );
+timerFree[ freeQty++ ] = timer;
+return 1;
+}
+
+
+/* startTimer - timer function for StartAfter */
+void startTimer( int, int ID )
+{
+Start( ID );
+}
+
+
+/* StartAfter - Start a task after a delay
+   Uses a one shot software timer so task can stay stopped until then,
+   Start is called when timer expires so same rules for starting apply.
+
+    Parameters  int Task ID to start
+                int delay in ms
+
+    Return int  -2  No free timers
+                -1  invalid ID or delay
+                >= 0 Timer number
+*/
+int StartAfter( int ID, int delay )
+{
+if( checkID( ID ) < 0 )
+  return -1;
+return timerStart( startTimer, ID, delay, 0 );
+}
+#endif
+
+
+#ifdef SCHEDULE_NAME
+}
+
+#ifdef SCHEDULE_TASK
+#ifndef SCHEDULE_INTERVAL
+#ifdef ENABLE_ADAPTIVE_TICK
+#define SCHEDULE_INTERVAL   TICK_MIN
+#else
+#define SCHEDULE_INTERVAL   MIN_TASK_INTERVAL
+#endif
+#endif
+#if defined( ENABLE_ADAPTIVE_TICK ) && SCHEDULE_INTERVAL < TICK_MIN
+#error SCHEDULE_INTERVAL cannot be less than TICK_MIN of the sub-scheduler
+#elif !defined( ENABLE_ADAPTIVE_TICK ) && SCHEDULE_INTERVAL < MIN_TASK_INTERVAL
+#error SCHEDULE_INTERVAL cannot be less than MIN_TASK_INTERVAL of the sub-scheduler
+#endif
+#ifdef SCHEDULE_PARENT
+namespace SCHEDULE_PARENT {
+#endif
+extern int setInterval( int, int );     // of parent scheduler
+extern unsigned long old_ms;            // pass time of parent scheduler
+
+
+/* SCHEDULE_TASK - Task of parent scheduler that runs this sub-scheduler
+   In namespace of parent like its other tasks. On initialise (status 0)
+   initialises tasks of this sub-scheduler and sets own interval in parent
+   to SCHEDULE_INTERVAL, then each run is one pass of this sub-scheduler.
+   The parent has already waited for the interval, so the pass is done at
+   the parent's pass time without the sub-scheduler's own MIN_TASK_INTERVAL
+   check, so a parent task running late (jitter) does not make it skip
+   passes. With ENABLE_ADAPTIVE_TICK the sub-scheduler still only does a
+   pass when one of its tasks is due. When the task is stopped none of this
+   runs.
+
+   Parameters  int Task ID in parent
+               int status
+
+   Returns     int -3  parent cannot use SCHEDULE_INTERVAL, as below its
+                       MIN_TASK_INTERVAL (error, task stopped)
+                   -2  Init of sub-scheduler failed (error, task stopped)
+                    1  running
+*/
+int SCHEDULE_TASK( int ID, int status )
+{
+if( status == 0 )
+  {
+  if( SCHEDULE_NAME::Init( ) < 0 )
+    return -2;
+  if( setInterval( ID, SCHEDULE_INTERVAL ) < 0 )
+    return -3;
+  return 1;
+  }
+SCHEDULE_NAME::passMs = old_ms;
+SCHEDULE_NAME::passForced = 1;
+SCHEDULE_NAME::Run( );
+SCHEDULE_NAME::passForced = 0;
+return 1;
+}
+#ifdef SCHEDULE_PARENT
+}
+#endif
+#endif
+#endif
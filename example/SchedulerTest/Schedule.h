@@ -18,21 +18,96 @@ See other documentation for details
 #ifndef SCHEDULE_H
 #define SCHEDULE_H
 
+#ifdef SCHEDULE_NAME
+// Functions of sub-scheduler (see Schedule.cpp) are in its own namespace
+namespace SCHEDULE_NAME {
+#include SCHEDULE_TASKLIST
+#else
 #include "Tasklist.h"
+#endif
 extern struct TaskList taskTable[ ];
 
 extern int Run();
 extern int Init( );
 #ifndef DISABLE_LOGGING
 extern struct TaskList *Log( );
+extern struct TaskView *LogTask( int );
 #endif
 #ifndef DISABLE_STATS
 extern struct Stats *getStats( );
 #endif
+#ifdef ENABLE_USAGE
+extern struct Usage *getUsage( );
+#endif
+#ifdef ENABLE_PROFILE
+extern struct Profile *getProfile( int );
+extern unsigned long clearProfile( );
+#endif
 extern int setInterval( int, int );
 extern int getInterval( int );
 extern unsigned long getTime( int );
 extern int getStatus( int );
 extern int Start( int );
 extern int FindID( int(* const )( int, int ) );
+extern int Trigger( int );
+extern unsigned long getNextRun( );
+#ifdef ENABLE_DEGRADE
+extern int setDegrade( int, int );
+extern int getDegrade( int );
+#endif
+#ifdef ENABLE_TIMERS
+extern int timerStart( void (* )( int, int ), int, int, int );
+extern int timerStop( int );
+extern int StartAfter( int, int );
+#endif
+#ifdef ENABLE_GROUPS
+extern int groupStart( int );
+extern int groupStop( int );
+extern int groupSuspend( int );
+extern int groupResume( int );
+extern int groupScale( int, int );
+extern int getSuspended( int );
+#endif
+#ifdef ENABLE_TELEMETRY
+extern int teleStart( void (* )( const unsigned char *, unsigned int ), unsigned int );
+extern int teleStop( );
+extern void teleKey( );
+#endif
+#ifdef ENABLE_LINUX_SHM
+extern int shmOpen( const char * );
+extern int shmClose( );
+#endif
+#ifdef ENABLE_LINUX_WATCHDOG
+// Settings for monitor thread see ScheduleWatch.cpp
+struct WatchConfig {
+                const char *logFile;    // crash log file, NULL stderr
+                int period;             // ms between checks
+                int stall;              // ms without call of Run that is
+                                        // logged as stalled, 0 no check
+                int abortOnKill;        // non zero abort after logging
+                };
+extern int StartWatch( const struct WatchConfig * );
+extern int StopWatch( );
+extern int setWatchLimit( int, unsigned long, unsigned long );
+extern unsigned long getOverruns( int );
+#endif
+#ifdef ENABLE_LINUX_RT
+// Settings for scheduler thread see ScheduleLinux.cpp
+struct RTConfig {
+                int priority;   // SCHED_FIFO priority 1 to 99, 0 normal
+                int cpu;        // CPU to run on, -1 any
+                int lockMemory; // non zero lock and prefault memory
+                int maxSleep;   // longest sleep in ms
+                };
+
+extern int RunThread( const struct RTConfig * );
+extern int StopThread( );
+#ifdef ENABLE_LINUX_EPOLL
+extern int bindFD( int, int, unsigned int );
+extern int unbindFD( int );
+#endif
+#endif
+#ifdef SCHEDULE_NAME
+}
+#endif
 #endif
@@ -16,8 +16,8 @@
         Flash one LED at 4Hz
         SW_LCD_RIGHT_MID Switch Button press interrupt flash second LED
                 at 10Hz for 2 seconds
-        Checksum memory space every 10ms
-        SW_LCD_RIGHT switch output checksum to LCD
+        CRC memory space in chunks every 10ms (MemCheck library task)
+        SW_LCD_RIGHT switch output last CRC to LCD
         SW_LCD_LEFT switch button press send log to serial
         SW_LCD_LEFT_MID switch button press send statistics to serial
 
@@ -36,16 +36,14 @@
 #include <LiquidCrystal.h>
 #include "IO.h"
 #include "Schedule.h"
-
-// Pointers for statistics printing
-struct TaskList *logptr;
+#include "MemCheck.h"
 
 int old_pot;        // last pot reading for determining change threshold
 int ID10Hz;         // Taks IDs for various tasks for helper functions
 int IDLCD;
 int IDSwitch;
-unsigned long checksum;         // RAM checksum for continuous checksums
 unsigned long checksize = 1024; // Number of ints to check
+unsigned int checkchunk = 256;  // Number of bytes to check per task run
 
 // Interrupt from switches flags to assist switch de-bounce
 volatile uint8_t Enable10Hz;
@@ -85,11 +83,10 @@ lcd.print( checksize * sizeof( int ), DEC );
 lcd.print( " bytes=" );
 lcd.setCursor( 0, 3 );
 lcd.print( "Log Stats 10Hz Check" );
+memCheckSetup( (const void *)0x20070000, checksize * sizeof( int ), checkchunk );
 Init( );                    // Initialise all tasks
 // Send initialisation log to serial
-logptr = taskTable;
 dumplog( );
-logptr = Log( );
 }
 
 
@@ -209,31 +206,7 @@ return status;
 }
 
 
-/* Task  -  Checksum Area of RAM every 10ms and save result */
-int CheckRAM( int ID, int status )
-{
-unsigned long i;
-unsigned int *ptr;
-
-switch( status )
-  {
-  case 0: // initialise
-          setInterval( ID, MIN_TASK_INTERVAL );
-          status = 2;
-          break;
-  case 1: // Start
-  case 2: // Perform Checksum
-          checksum = 0;
-          ptr = (unsigned int *)0x20070000;
-          for( i = 0; i < checksize; i++ )
-             checksum += *ptr++;
-          status = 3;
-  }
-return status;
-}
-
-
-/* Task - Output last Checksum to LCD
+/* Task - Output last CRC of RAM to LCD
    Triggered by switch SW_LCD_RIGHT
    At end of running re-enable switch flag for next push */
 int CheckLCD( int ID, int status )
@@ -253,9 +226,9 @@ switch( status )
           lcd.print( "        " );
           status = 2;
           break;
-  case 2: // Write last Checksum to LCD then stop
+  case 2: // Write last CRC to LCD then stop
           lcd.setCursor( 12, 2 );
-          lcd.print( checksum, HEX );
+          lcd.print( getMemStats( )->crc, HEX );
           EnableCS = 0;
           status = 0;
   }
@@ -310,23 +283,34 @@ return status;
 void dumplog( )
 {
 int i;
+struct TaskView *logptr;
 
 Serial.print( "\nCurrent time - " );
 Serial.println( millis(), DEC );
+#ifdef ENABLE_STAGGER
+Serial.println( "ID\tNext\tTook\tStatus\tInter\tRan\tPhase" );
+#else
 Serial.println( "ID\tNext\tTook\tStatus\tInter\tRan" );
+#endif
 for( i = 0; i < (int)_MAX_TASKS; i++ )
    {
+   logptr = LogTask( i );
    Serial.print( i, DEC );
    Serial.write( '\t' );
-   Serial.print( logptr[ i ].next, DEC );
+   Serial.print( logptr->next, DEC );
+   Serial.write( '\t' );
+   Serial.print( logptr->last, DEC );
    Serial.write( '\t' );
-   Serial.print( logptr[ i ].last, DEC );
+   Serial.print( logptr->status, DEC );
    Serial.write( '\t' );
-   Serial.print( logptr[ i ].status, DEC );
+   Serial.print( logptr->interval, DEC );
    Serial.write( '\t' );
-   Serial.print( logptr[ i ].interval, DEC );
+   Serial.print( logptr->executed, DEC );
+#ifdef ENABLE_STAGGER
    Serial.write( '\t' );
-   Serial.println( logptr[ i ].executed, DEC );
+   Serial.print( logptr->phase, DEC );
+#endif
+   Serial.println( );
    }
 }
 
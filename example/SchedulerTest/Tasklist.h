@@ -23,7 +23,7 @@ extern int brightnessCheck( int, int ); // read pot set PWM brightness
 extern int LED4hz( int, int );          // Flash LED 1 at 4 Hz  (continuous)
 extern int LED10Hz( int, int );         // Flash LED 2 at 10Hz for 2 Seconds
                                         // on switch press. Initially off
-extern int CheckRAM( int, int );        // Checksum 1st 1k of RAM every 10ms
+#include "MemCheck.h"                   // CRC of 4k of RAM in chunks every 10ms
 extern int CheckLCD( int, int );        // output Checksum to LCD
 extern int statisticsCheck( int, int ); // See if we output statistics
 
@@ -51,7 +51,7 @@ int ( * const tasks[])( int, int ) =
                 LED4hz,         // Flash LED 1 at 4 Hz  (continuous)
                 LED10Hz,        // Flash LED 2 at 10Hz for 2 Seconds
                                 // on switch press. Initially off
-                CheckRAM,       // Checksum 1st 1k of RAM every 10ms
+                MemCheck,       // CRC of 4k of RAM in chunks every 10ms
                 CheckLCD,       // output Checksum to LCD
                 statisticsCheck	// See if we output statistics
                 };
@@ -89,6 +89,195 @@ int ( * const tasks[])( int, int ) =
 //#define DISABLE_LOGGING
 //#define DISABLE_STATS
 
+/* Time tasks and passes with the processor cycle counter instead of micros( )
+   and millis( ), cheaper to read and fine enough for tasks well under 1 us.
+   Task last, maxExec, maxLoop, CPU use and profile times are then in ns
+   (unsigned long so longest time 4.29 s on 32 bit processors). Counter is
+   DWT on Cortex-M3/M4/M7 (F_CPU counts per second), rdtsc on x86 and CNTVCT
+   on 64 bit ARM Linux hosts, scaled to ns at Init.
+   Uncomment the following line to use */
+//#define ENABLE_CYCLE_CLOCK
+
+/* Smaller task table for tables of thousands of tasks or boards short of
+   RAM, each task takes 8 bytes (10 with ENABLE_STAGGER) instead of 20 on 32
+   bit processors. Only low 16 bits of next run time are kept so Run must be
+   called at least every 32 s, intervals are up to 32767 ms (setInterval
+   returns -2 for longer) and last run time up to 65535 (longer shows 65535).
+   Log gives packed entries, LogTask one task at full width. ENABLE_DUE_MASK
+   does not use SSE2/AVX2 with this. Uncomment the following line to use */
+//#define ENABLE_COMPACT
+
+/* For large task tables finding which tasks are due can be done as a bitmask
+   over the whole table first (using SSE2 or AVX2 when compiled for them) then
+   only due tasks are run. Uncomment the following line to use */
+//#define ENABLE_DUE_MASK
+
+/* Software timers call a function or start a task after a delay without using
+   a task, MAX_TIMERS is how many can be active at once.
+   Uncomment the following line to use */
+//#define ENABLE_TIMERS
+#define MAX_TIMERS      16
+
+/* Spread first run of tasks started at Init or Start so tasks with same or
+   harmonic intervals are not all due in the same pass, cuts longest pass time
+   without changing how often any task runs. Works out load over a window of
+   STAGGER_SLOTS passes (best a multiple of intervals used divided by
+   MIN_TASK_INTERVAL). Phase of each task is shown in Log.
+   Uncomment the following line to use */
+//#define ENABLE_STAGGER
+#define STAGGER_SLOTS       64
+
+/* Task links, when a producer task returns the status given (or any status
+   with LINK_ANY) its consumer task is run in the same pass, after the list
+   in topological order, so results are used without waiting for consumer's
+   interval. Consumers still run at their own interval and must be started.
+   Each link is { producer ID, consumer ID, status }, Init returns -2 if
+   links form a loop. Uncomment the following line to use */
+//#define ENABLE_LINKS
+#ifdef ENABLE_LINKS
+#define LINK_ANY    -1
+const int taskLinks[ ][ 3 ] =
+                {
+                { 3, 4, 1 }     // MemCheck finished scan (returns 1) so
+                                // CheckLCD shows new CRC (when started)
+                };
+#endif
+
+/* Task groups, named sets of tasks (e.g. a subsystem) started, stopped,
+   suspended (held keeping status), resumed or with intervals scaled in one
+   call, see groupStart. Each group in taskGroups is a bitmask of its tasks,
+   bit n of word w is task ID w * 32 + n (more words only needed over 32
+   tasks). Changes are all applied together at start of the next pass so a
+   group is never seen half changed. Uncomment the following line to use */
+//#define ENABLE_GROUPS
+#ifdef ENABLE_GROUPS
+#define _GROUP_WORDS    ( ( sizeof( tasks ) / sizeof( tasks[ 0 ] ) + 31 ) / 32 )
+#define GROUP_INPUTS    0       // names of groups, index in taskGroups
+#define GROUP_OUTPUTS   1
+const uint32_t taskGroups[ ][ _GROUP_WORDS ] =
+                {
+                { 0x00000003 },         // e.g. GROUP_INPUTS tasks 0 and 1
+                { 0x00000004 }          // GROUP_OUTPUTS task 2
+                };
+#endif
+
+/* Adaptive tick, instead of a pass every MIN_TASK_INTERVAL the next pass is
+   when the next task or timer is due, but not sooner than TICK_MIN ms or the
+   time the last pass took, and not later than TICK_MAX ms. Intervals can then
+   be as short as TICK_MIN. Overdue statistics are how late Run was called
+   after the pass was due. Uncomment the following line to use */
+//#define ENABLE_ADAPTIVE_TICK
+#define TICK_MIN            1
+#define TICK_MAX            100
+
+/* Overload control, tasks made degradable with setDegrade have their
+   interval stretched (times 2 for each level up to DEGRADE_MAX) when the
+   overdue average reaches DEGRADE_HIGH ms or a pass takes MIN_TASK_INTERVAL,
+   lowest priority (end of list) first. Restored highest priority first when
+   overdue average is down to DEGRADE_LOW ms. DEGRADE_HOLD passes between
+   changes. Needs statistics, uncomment the following line to use */
+//#define ENABLE_DEGRADE
+#define DEGRADE_MAX         4
+#define DEGRADE_HIGH        5
+#define DEGRADE_LOW         1
+#define DEGRADE_HOLD        16
+
+/* Cyclic executive for fixed timing, each pass just runs the tasks listed for
+   the next minor frame (of MIN_TASK_INTERVAL ms) in the tables below, no due
+   time checks so every pass has same overhead. Intervals are not used and
+   Trigger does nothing. Make tables with tools/cyclicgen.cpp from periods of
+   your tasks to replace example below. Cannot be used with ENABLE_DUE_MASK,
+   ENABLE_BACKGROUND, ENABLE_PASS_BUDGET or ENABLE_STAGGER.
+   Uncomment the following line to use */
+//#define ENABLE_CYCLIC
+#ifdef ENABLE_CYCLIC
+/* Cyclic executive tables made by cyclicgen 10 10 20 40
+   Hyperperiod 40 ms, 4 frames of 10 ms, busiest frame 2 tasks
+
+    ID  period  offset
+     0      10       0
+     1      20       0
+     2      40      10
+*/
+#define CYCLIC_FRAMES   4
+const unsigned int cyclicFrame[ CYCLIC_FRAMES + 1 ] = {
+                0, 2, 4, 6, 7 };
+const unsigned short cyclicTasks[ 7 ] = {
+                0, 1, 0, 2, 0, 1, 0 };
+#endif
+
+/* Background tasks only use spare time, the last BACKGROUND_TASKS in the list
+   of tasks are run after all due tasks when their interval has passed AND
+   there is more than BACKGROUND_SLACK ms before the next task is due.
+   Uncomment the following line to use */
+//#define ENABLE_BACKGROUND
+#define BACKGROUND_TASKS    1
+#define BACKGROUND_SLACK    2
+
+/* Limit time of each call to Run to PASS_BUDGET us (checked after each task),
+   when a pass takes longer the rest of it is done on the following call(s)
+   so loop( ) and Arduino background activities get a look in.
+   Uncomment the following line to use */
+//#define ENABLE_PASS_BUDGET
+#define PASS_BUDGET         5000
+
+/* Linux hosts only, run scheduler on its own thread that sleeps until next
+   task is due, with optional real time priority and locked memory.
+   See ScheduleLinux.cpp, uncomment the following line to use */
+//#define ENABLE_LINUX_RT
+
+/* Linux hosts with ENABLE_LINUX_RT only, tasks can be run when a file
+   descriptor (socket, pipe, serial port...) is ready, using epoll.
+   Uncomment the following line to use */
+//#define ENABLE_LINUX_EPOLL
+
+/* Linux hosts only, monitor thread that counts tasks running longer than
+   WATCH_WARN us (overruns) and logs tasks running longer than WATCH_KILL us
+   (hung) with a stack trace, optionally aborting. Limits can be set for each
+   task, see ScheduleWatch.cpp. Uncomment the following line to use */
+//#define ENABLE_LINUX_WATCHDOG
+#define WATCH_WARN          10000
+#define WATCH_KILL          1000000
+
+/* Linux hosts only, publish task table and statistics every pass to shared
+   memory for other programs to monitor. See ScheduleShm.cpp
+   Uncomment the following line to use */
+//#define ENABLE_LINUX_SHM
+
+/* CPU use of each task and of the scheduler itself, as run count, total time
+   and average use over USAGE_WINDOWS windows of USAGE_TIMES ms, updated every
+   USAGE_SAMPLE ms. See getUsage, uncomment the following line to use */
+//#define ENABLE_USAGE
+#define USAGE_SAMPLE        100
+#define USAGE_WINDOWS       3
+#define USAGE_TIMES         { 1000, 10000, 60000 }
+
+/* Execution time of each task broken down by the status it was called with
+   (its state), as runs, total and longest time of each task and state seen.
+   Up to PROFILE_SIZE (power of 2) task and state pairs are kept, later new
+   pairs are only counted as dropped. See getProfile, uncomment the following line to use */
+//#define ENABLE_PROFILE
+#define PROFILE_SIZE        64
+
+/* Send task table and statistics changes as compact binary frames to a
+   function of the sketch (e.g. writing to Serial), see ScheduleTele.cpp and
+   tools/teledecode.cpp. Full keyframe every TELEMETRY_KEYFRAME frames.
+   Uncomment the following line to use */
+//#define ENABLE_TELEMETRY
+#define TELEMETRY_KEYFRAME  64
+
+/* Instrumentation hooks, define any of these to add your own code for tracing,
+   counters or watchdog kicks (best as simple statements or inline functions
+   declared in includes at top of this file). Ones not defined compile to
+   nothing.
+        SCHEDULE_BEFORE_TASK( ID, status )      before task is called
+        SCHEDULE_AFTER_TASK( ID, status, us )   after task, new status and
+                                                time taken in us (ns with
+                                                ENABLE_CYCLE_CLOCK)
+        SCHEDULE_END_PASS( done )               end of pass, tasks run
+   For example */
+//#define SCHEDULE_END_PASS( done )   watchdogKick( )
+
 /*****************************************************************/
 /* Do not edit below here things will break demons will be found */
 /*****************************************************************/
@@ -97,27 +286,93 @@ int ( * const tasks[])( int, int ) =
 
 /* Following structures and copy for snapshots for reporting and analysis
   Structures  for task details next run, status etc.. */
+#ifdef ENABLE_COMPACT
+struct TaskList {
+                unsigned short next;    // low 16 bits of next execution time
+                unsigned short last;    // last execution time in us (ns)
+                short status;           // current task status as below
+                unsigned short interval : 15;   // interval between starts in ms
+                unsigned short executed : 1;    // did run this pass = 1
+#ifdef ENABLE_STAGGER
+                short phase;            // first run this many ms earlier
+#endif
+                };
+#else
 struct TaskList {
                 unsigned long next;     // next execution time in ms
-                unsigned long last;     // last execution time in us
+                unsigned long last;     // last execution time in us (ns)
                 int status;             // current task status 0 stopped,
                                         // -ve stopped with error,
                                         // 1 start,
                                         // >1 user status (and active)
                 int interval;           // interval between starts in ms
                 int executed;		    // did run this pass = 1
+#ifdef ENABLE_STAGGER
+                int phase;              // first run this many ms earlier
+                                        // than interval (at Init or Start)
+#endif
+                };
+#endif
+
+// Task details at full width for any settings, see LogTask
+struct TaskView {
+                unsigned long next;     // next execution time in ms
+                unsigned long last;     // last execution time in us (ns)
+                int status;             // current task status
+                int interval;           // interval between starts in ms
+                int executed;           // did run this pass = 1
+                int phase;              // ENABLE_STAGGER phase, 0 without
                 };
 
 // Structure for keeping statistics on scheduling
 struct Stats    {
                 unsigned long start;     // pass start time (ms)
                 unsigned long finish;    // pass end time (ms)
-                unsigned long maxExec;   // maximum execution time (us)
+                unsigned long maxExec;   // maximum execution time (us or ns)
                 int maxID;               // Task with maximum execution time
                 unsigned int qty;        // number of tasks run last pass
                 unsigned int overdue;    // overdue time (how late scheduler was called)
                 unsigned int overdueMax; // largest overdue time
                 unsigned int overdueAvg; // Average overdue time
-                unsigned int maxLoop;    // Longest schedule loop time
+                unsigned int maxLoop;    // Longest schedule loop time (ms or ns)
+#ifdef ENABLE_BACKGROUND
+                unsigned long slackUsed; // time in background tasks last pass (us)
+                unsigned int bgQty;      // background tasks run last pass
+#endif
+#ifdef ENABLE_PASS_BUDGET
+                unsigned int budgetHits; // passes split over PASS_BUDGET
+#endif
+#ifdef ENABLE_ADAPTIVE_TICK
+                unsigned long tick;      // time from last pass to next (ms)
+#endif
+#ifdef ENABLE_DEGRADE
+                unsigned int degraded;   // tasks with interval stretched now
+                unsigned long degrades;  // times an interval was stretched
+                unsigned long restores;  // times an interval was restored
+#endif
+#ifdef ENABLE_LINUX_RT
+                unsigned long wakeLatency; // last wake up late from sleep (us)
+                unsigned long wakeMax;     // largest wake up latency (us)
+#endif
+                };
+
+#ifdef ENABLE_USAGE
+// Structure for CPU use of a task or scheduler
+struct Usage    {
+                unsigned long runs;         // times run (scheduler - calls)
+                unsigned long long total;   // total run time (us or ns)
+                unsigned long util[ USAGE_WINDOWS ];  // average use over each
+                                            // window in parts per million
                 };
 #endif
+#ifdef ENABLE_PROFILE
+// Structure for execution time of a task in one state
+struct Profile  {
+                int ID;                     // task
+                int status;                 // status task was called with
+                unsigned long runs;         // times run in this state
+                unsigned long long total;   // total run time (us or ns)
+                unsigned long max;          // longest run time (us or ns)
+                };
+#endif
+#endif
@@ -0,0 +1,316 @@
+/* Scheduler - synthetic workload generator
+
+  Created 2016
+  by Paul Carpenter
+
+  Generates a task set of WORK_TASKS periodic tasks, runs it on the scheduler
+  for WORK_TIME seconds then reports how well the scheduler kept up. Used to
+  compare scheduler changes and options (e.g. list order against
+  ENABLE_DUE_MASK, ENABLE_PASS_BUDGET) on the same task sets at scale, instead
+  of only the six tasks of SchedulerTest.
+
+  Task set is made from a seed so the same settings always give the same set
+  on any board or host.
+
+    Periods         WORK_PERIODS 0 harmonic, MIN_TASK_INTERVAL times a power
+                                   of 2 up to WORK_PMAX ms
+                                 1 log-uniform between WORK_PMIN and
+                                   WORK_PMAX ms
+    Utilisation     WORK_UTIL percent of CPU in total, split between tasks
+                    using UUniFast so every split is equally likely
+    Execution time  Worst case is task utilisation times period, each run is
+                    WORK_EXEC 0 always worst case
+                              1 uniform between half and all of worst case
+                              2 bimodal, 1 in 10 worst case others quarter
+                    Tasks busy wait for their execution time
+
+  Each run of a task is a job released every period from when it was started,
+  so a job that starts late or a task that falls behind (scheduler works out
+  next run from pass start time so lateness can add up) shows up.
+
+    lateness    time from release to job starting (us)
+    miss        job finished more than a period after release, or never run
+                before next release (skipped, counted as miss as well)
+    pass        time of each call of Run that ran a pass (us)
+
+  Results sent to serial port (115,200 baud), first the settings, then one
+  line per task, then totals as CSV lines
+
+    task,ID,period_ms,wcet_us,jobs,misses,late_avg_us,late_max_us
+    total,tasks,util,jobs,misses,skipped,late_avg_us,late_max_us,passes,pass_avg_us,pass_max_us
+
+  All settings can be changed below or from compiler command line with -D,
+  WORK_TASKS is in Tasklist.h.
+*/
+#include <Arduino.h>
+#include <math.h>
+#include "Schedule.h"
+
+#ifndef WORK_UTIL
+#define WORK_UTIL       50      // total utilisation percent
+#endif
+#ifndef WORK_PERIODS
+#define WORK_PERIODS    0       // 0 harmonic, 1 log-uniform
+#endif
+#ifndef WORK_PMIN
+#define WORK_PMIN       MIN_TASK_INTERVAL   // shortest period ms
+#endif
+#ifndef WORK_PMAX
+#define WORK_PMAX       1000    // longest period ms
+#endif
+#ifndef WORK_EXEC
+#define WORK_EXEC       0       // 0 worst case, 1 uniform, 2 bimodal
+#endif
+#ifndef WORK_SEED
+#define WORK_SEED       1       // seed of task set
+#endif
+#ifndef WORK_TIME
+#define WORK_TIME       10      // seconds to run before reporting
+#endif
+
+// Task set and per task results
+unsigned int workPeriod[ _MAX_TASKS ];      // period ms
+unsigned long workWCET[ _MAX_TASKS ];       // worst case execution time us
+unsigned long workRelease[ _MAX_TASKS ];    // release time of next job us
+unsigned long workJobs[ _MAX_TASKS ];
+unsigned long workMisses[ _MAX_TASKS ];
+unsigned long workSkipped[ _MAX_TASKS ];
+unsigned long workLateMax[ _MAX_TASKS ];
+unsigned long long workLateTotal[ _MAX_TASKS ];
+
+// Pass times
+unsigned long passes = 0;
+unsigned long passMax = 0;
+unsigned long long passTotal = 0;
+
+unsigned long workSeed;
+unsigned long workStart;        // time measuring started ms
+int measuring = 0;
+
+void report( );
+
+
+/* workRandom - Repeatable random number 0 to 1 (xorshift32) */
+double workRandom( )
+{
+workSeed ^= workSeed << 13;
+workSeed ^= ( workSeed & 0xFFFFFFFFUL ) >> 17;
+workSeed ^= workSeed << 5;
+workSeed &= 0xFFFFFFFFUL;
+return ( workSeed >> 8 ) / 16777216.0;
+}
+
+
+/* workPeriods - Make period of each task */
+void workPeriods( )
+{
+int i, steps;
+
+for( steps = 0; ( (long)WORK_PMIN << ( steps + 1 ) ) <= WORK_PMAX; steps++ );
+for( i = 0; i < (int)_MAX_TASKS; i++ )
+   {
+#if WORK_PERIODS == 0
+   workPeriod[ i ] = WORK_PMIN << (int)( workRandom( ) * ( steps + 1 ) );
+#else
+   workPeriod[ i ] = (unsigned int)( exp( log( (double)WORK_PMIN )
+                        + workRandom( ) * ( log( (double)WORK_PMAX )
+                                            - log( (double)WORK_PMIN ) ) ) + 0.5 );
+#endif
+   if( workPeriod[ i ] < MIN_TASK_INTERVAL )
+     workPeriod[ i ] = MIN_TASK_INTERVAL;
+   if( workPeriod[ i ] > 32767 )
+     workPeriod[ i ] = 32767;
+   }
+}
+
+
+/* workUtilisation - Split WORK_UTIL between tasks using UUniFast and set
+   worst case execution time of each task from its share and period */
+void workUtilisation( )
+{
+int i;
+double sum, next, util;
+
+sum = WORK_UTIL / 100.0;
+for( i = 0; i < (int)_MAX_TASKS; i++ )
+   {
+   if( i < (int)_MAX_TASKS - 1 )
+     {
+     next = sum * pow( workRandom( ), 1.0 / ( _MAX_TASKS - 1 - i ) );
+     util = sum - next;
+     sum = next;
+     }
+   else
+     util = sum;
+   if( util > 1.0 )
+     util = 1.0;
+   workWCET[ i ] = (unsigned long)( util * workPeriod[ i ] * 1000.0 );
+   }
+}
+
+
+void setup( )
+{
+int i;
+unsigned long ms, us;
+
+Serial.begin( 115200 );
+Init( );
+workSeed = WORK_SEED;
+if( workSeed == 0 )
+  workSeed = 1;             // xorshift never leaves 0
+workPeriods( );
+workUtilisation( );
+
+ms = millis( );
+us = micros( );
+for( i = 0; i < (int)_MAX_TASKS; i++ )
+   {
+   setInterval( i, workPeriod[ i ] );
+   Start( i );
+   workRelease[ i ] = us + ( getTime( i ) - ms ) * 1000UL;
+   }
+workStart = ms;
+measuring = 1;
+
+Serial.print( "workload tasks " );
+Serial.print( (unsigned long)_MAX_TASKS, DEC );
+Serial.print( " util " );
+Serial.print( WORK_UTIL, DEC );
+Serial.print( " periods " );
+Serial.print( WORK_PERIODS ? "log-uniform " : "harmonic " );
+Serial.print( WORK_PMIN, DEC );
+Serial.print( "-" );
+Serial.print( WORK_PMAX, DEC );
+Serial.print( " exec " );
+Serial.print( WORK_EXEC, DEC );
+Serial.print( " seed " );
+Serial.print( WORK_SEED, DEC );
+Serial.print( " time " );
+Serial.println( WORK_TIME, DEC );
+}
+
+
+void loop( )
+{
+unsigned long us;
+
+us = micros( );
+if( Run( ) >= 0 && measuring )
+  {
+  us = micros( ) - us;
+  passes++;
+  passTotal += us;
+  if( us > passMax )
+    passMax = us;
+  }
+if( measuring && millis( ) - workStart >= WORK_TIME * 1000UL )
+  {
+  measuring = 0;
+  report( );
+  }
+}
+
+
+/* Task - synthetic task busy waits for its execution time
+   Checks lateness of job against release time and for missed deadline
+   (deadline is end of period) */
+int workTask( int ID, int status )
+{
+unsigned long start, exec, late, period;
+
+if( status == 0 )
+  return 0;                 // stopped until set up
+start = micros( );
+period = workPeriod[ ID ] * 1000UL;
+
+// jobs never started before next release are skipped
+while( (long)( start - workRelease[ ID ] ) >= (long)period )
+  {
+  if( measuring )
+    {
+    workSkipped[ ID ]++;
+    workMisses[ ID ]++;
+    }
+  workRelease[ ID ] += period;
+  }
+late = (long)( start - workRelease[ ID ] ) > 0 ? start - workRelease[ ID ] : 0;
+
+#if WORK_EXEC == 0
+exec = workWCET[ ID ];
+#elif WORK_EXEC == 1
+exec = (unsigned long)( workWCET[ ID ] * ( 0.5 + workRandom( ) / 2 ) );
+#else
+exec = workRandom( ) < 0.1 ? workWCET[ ID ] : workWCET[ ID ] / 4;
+#endif
+while( micros( ) - start < exec );
+
+if( measuring )
+  {
+  workJobs[ ID ]++;
+  workLateTotal[ ID ] += late;
+  if( late > workLateMax[ ID ] )
+    workLateMax[ ID ] = late;
+  if( (long)( micros( ) - workRelease[ ID ] ) > (long)period )
+    workMisses[ ID ]++;
+  }
+workRelease[ ID ] += period;
+return 2;
+}
+
+
+/* Send CSV results */
+void report( )
+{
+int i;
+unsigned long jobs, misses, skipped, lateMax;
+unsigned long long lateTotal;
+
+jobs = misses = skipped = lateMax = 0;
+lateTotal = 0;
+Serial.println( "task,ID,period_ms,wcet_us,jobs,misses,late_avg_us,late_max_us" );
+for( i = 0; i < (int)_MAX_TASKS; i++ )
+   {
+   Serial.print( "task," );
+   Serial.print( i, DEC );
+   Serial.write( ',' );
+   Serial.print( workPeriod[ i ], DEC );
+   Serial.write( ',' );
+   Serial.print( workWCET[ i ], DEC );
+   Serial.write( ',' );
+   Serial.print( workJobs[ i ], DEC );
+   Serial.write( ',' );
+   Serial.print( workMisses[ i ], DEC );
+   Serial.write( ',' );
+   Serial.print( workJobs[ i ] ? (unsigned long)( workLateTotal[ i ] / workJobs[ i ] ) : 0UL, DEC );
+   Serial.write( ',' );
+   Serial.println( workLateMax[ i ], DEC );
+   jobs += workJobs[ i ];
+   misses += workMisses[ i ];
+   skipped += workSkipped[ i ];
+   lateTotal += workLateTotal[ i ];
+   if( workLateMax[ i ] > lateMax )
+     lateMax = workLateMax[ i ];
+   }
+Serial.println( "total,tasks,util,jobs,misses,skipped,late_avg_us,late_max_us,passes,pass_avg_us,pass_max_us" );
+Serial.print( "total," );
+Serial.print( (unsigned long)_MAX_TASKS, DEC );
+Serial.write( ',' );
+Serial.print( WORK_UTIL, DEC );
+Serial.write( ',' );
+Serial.print( jobs, DEC );
+Serial.write( ',' );
+Serial.print( misses, DEC );
+Serial.write( ',' );
+Serial.print( skipped, DEC );
+Serial.write( ',' );
+Serial.print( jobs ? (unsigned long)( lateTotal / jobs ) : 0UL, DEC );
+Serial.write( ',' );
+Serial.print( lateMax, DEC );
+Serial.write( ',' );
+Serial.print( passes, DEC );
+Serial.write( ',' );
+Serial.print( passes ? (unsigned long)( passTotal / passes ) : 0UL, DEC );
+Serial.write( ',' );
+Serial.println( passMax, DEC );
+}
@@ -0,0 +1,180 @@
+/* Mailboxes for passing messages between tasks for Co-operative Scheduler
+
+Author: Paul Carpenter, PC Services, <sales@pcserviceselectronics.co.uk>
+
+Tasks sharing data through global variables need copies or flags to stop one
+side reading while the other is writing, especially when one side is an
+interrupt or (on Linux hosts) another thread. A mailbox is a ring of fixed
+size message buffers in memory given by the sketch (no heap), owned in turn
+by the producer and the consumer, so messages like sensor readings are
+written in place and handed over by pointer without copying.
+
+Each mailbox has ONE producer and ONE consumer (each a task, interrupt or
+thread), they can be different types. No locks or disabling interrupts are
+needed as the producer only changes head and the consumer only changes tail
+(single bytes so atomic on all processors), with memory barriers so buffer
+contents are seen before the hand over.
+
+Producer                            Consumer
+    ptr = mailAlloc( &box );            ptr = mailGet( &box );
+    if( ptr != NULL )                   if( ptr != NULL )
+      {                                   {
+      fill in message at ptr              use message at ptr
+      mailPost( &box );                   mailRelease( &box );
+      }                                   }
+
+A message stays in its buffer until the consumer releases it, if all buffers
+are waiting mailAlloc returns NULL and the producer decides what to do (count
+in full, drop or try later).
+
+When a wake task ID is given to mailInit, posting a message does Trigger on
+that task so the consumer task is run on the next call of Run rather than
+waiting for its interval (it must be started), also when posted while the
+consumer task is running. With RunThread (ENABLE_LINUX_RT) a post from
+another thread wakes the scheduler thread so that call is straight away.
+
+Functions
+---------
+mailInit    Set up mailbox with its buffers
+mailAlloc   Producer get next free buffer to fill
+mailPost    Producer hand over filled buffer to consumer
+mailGet     Consumer get oldest message
+mailRelease Consumer finished with message, buffer free for producer
+mailWaiting Number of messages posted not yet released
+*/
+#include <Arduino.h>
+#include "Schedule.h"
+#include "Mailbox.h"
+
+// Memory barrier so buffer contents and head/tail are seen in order
+#if defined( __AVR__ )
+#define _MAIL_BARRIER( )    __asm__ __volatile__( "" ::: "memory" )
+#else
+#define _MAIL_BARRIER( )    __sync_synchronize( )
+#endif
+
+
+/* mailInit - Set up mailbox
+   Call before producer or consumer use it
+
+   Parameters  pointer       mailbox
+               pointer       memory for buffers, slots * size bytes
+               unsigned int  bytes in each message buffer
+               unsigned int  number of buffers 2, 4, 8, 16, 32, 64 or 128
+               int           task ID to Trigger when message posted, -1 none
+
+   Returns     int  -1 invalid parameters
+                     1 ready
+*/
+int mailInit( struct Mailbox *box, void *buffers, unsigned int size,
+              unsigned int slots, int wakeID )
+{
+if( box == NULL || buffers == NULL || size == 0
+    || slots < 2 || slots > 128 || ( slots & ( slots - 1 ) ) )
+  return -1;
+box->buffers = (unsigned char *)buffers;
+box->size = size;
+box->mask = slots - 1;
+box->head = 0;
+box->tail = 0;
+box->wakeID = wakeID;
+box->posted = 0;
+box->full = 0;
+return 1;
+}
+
+
+/* mailAlloc - Producer get next free buffer to fill
+   Same buffer is returned until mailPost
+
+   Parameters  pointer  mailbox
+
+   Returns     pointer to buffer (size bytes) or NULL all buffers in use
+*/
+void *mailAlloc( struct Mailbox *box )
+{
+unsigned char head;
+
+head = box->head;
+if( (unsigned char)( head - box->tail ) > box->mask )
+  {
+  box->full++;
+  return NULL;
+  }
+return box->buffers + (unsigned int)( head & box->mask ) * box->size;
+}
+
+
+/* mailPost - Producer hand over buffer from mailAlloc to consumer
+   Producer must not use buffer after this
+
+   Parameters  pointer  mailbox
+
+   Returns     int  -1 no buffer allocated (all in use)
+                    >0 messages now waiting
+*/
+int mailPost( struct Mailbox *box )
+{
+unsigned char head;
+
+head = box->head;
+if( (unsigned char)( head - box->tail ) > box->mask )
+  return -1;
+_MAIL_BARRIER( );                   // message written before hand over
+box->head = head + 1;
+box->posted++;
+if( box->wakeID >= 0 )
+  Trigger( box->wakeID );
+return (unsigned char)( head + 1 - box->tail );
+}
+
+
+/* mailGet - Consumer get oldest message
+   Same message is returned until mailRelease
+
+   Parameters  pointer  mailbox
+
+   Returns     pointer to message (size bytes) or NULL none waiting
+*/
+void *mailGet( struct Mailbox *box )
+{
+unsigned char tail;
+
+tail = box->tail;
+if( box->head == tail )
+  return NULL;
+_MAIL_BARRIER( );                   // head read before message
+return box->buffers + (unsigned int)( tail & box->mask ) * box->size;
+}
+
+
+/* mailRelease - Consumer finished with message from mailGet
+   Consumer must not use message after this
+
+   Parameters  pointer  mailbox
+
+   Returns     int  -1 no message waiting
+                    >=0 messages still waiting
+*/
+int mailRelease( struct Mailbox *box )
+{
+unsigned char tail;
+
+tail = box->tail;
+if( box->head == tail )
+  return -1;
+_MAIL_BARRIER( );                   // message read before buffer reused
+box->tail = tail + 1;
+return (unsigned char)( box->head - ( tail + 1 ) );
+}
+
+
+/* mailWaiting - Number of messages posted and not yet released
+   Parameters  pointer  mailbox
+
+   Returns     int  number of messages
+*/
+int mailWaiting( struct Mailbox *box )
+{
+return (unsigned char)( box->head - box->tail );
+}
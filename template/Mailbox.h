@@ -0,0 +1,29 @@
+/* Mailboxes for passing messages between tasks for Co-operative Scheduler
+
+   Optional library of single producer single consumer mailboxes of fixed
+   size message buffers, passed by pointer so no copying
+
+See Mailbox.cpp for details
+*/
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+// Mailbox, set up with mailInit
+struct Mailbox  {
+                unsigned char *buffers;     // slots message buffers
+                unsigned int size;          // bytes in each message buffer
+                unsigned char mask;         // slots - 1
+                volatile unsigned char head;    // buffers posted (producer)
+                volatile unsigned char tail;    // buffers released (consumer)
+                int wakeID;                 // task to Trigger on post, -1 none
+                volatile unsigned long posted;  // messages posted
+                volatile unsigned long full;    // mailAlloc found no buffer
+                };
+
+extern int mailInit( struct Mailbox *, void *, unsigned int, unsigned int, int );
+extern void *mailAlloc( struct Mailbox * );
+extern int mailPost( struct Mailbox * );
+extern void *mailGet( struct Mailbox * );
+extern int mailRelease( struct Mailbox * );
+extern int mailWaiting( struct Mailbox * );
+#endif
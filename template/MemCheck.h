@@ -0,0 +1,23 @@
+/* Memory integrity check task for Co-operative Scheduler
+
+   Optional library task that CRCs an area of memory a chunk at a time
+
+See MemCheck.cpp for details
+*/
+#ifndef MEMCHECK_H
+#define MEMCHECK_H
+
+// Results of last complete scan of memory area
+struct MemStats {
+                unsigned long crc;      // CRC32C of area
+                unsigned long scans;    // number of complete scans done
+                unsigned long bytes;    // size of area in bytes
+                unsigned long scanTime; // time spent scanning area (us)
+                unsigned long rate;     // throughput in bytes per second
+                };
+
+extern int memCheckSetup( const void *, unsigned long, unsigned int );
+extern int MemCheck( int, int );
+extern struct MemStats *getMemStats( );
+extern unsigned long crc32c( unsigned long, const void *, unsigned long );
+#endif
@@ -0,0 +1,595 @@
+/* Co-operative Scheduler Linux host runtime
+
+Author: Paul Carpenter, PC Services, <sales@pcserviceselectronics.co.uk>
+
+Only built on Linux with ENABLE_LINUX_RT defined in Tasklist.h, on other
+platforms this file compiles to nothing so can stay in sketch folder.
+
+On a Linux host calling Run continuously from loop( ) wastes a CPU and the
+OS decides when the scheduler gets to run, so overdue times are mostly down to
+the OS. This runs the scheduler on its own thread that
+
+    Optionally runs at SCHED_FIFO real time priority
+    Optionally is pinned to one CPU
+    Optionally locks all memory (mlockall) and prefaults its stack so no
+        page faults occur once running
+    Sleeps until next task is due on an absolute time so drift in working
+        out sleep time does not add up, woken early by Trigger from other
+        threads so their events are run straight away
+
+Real time priority and locking memory normally need root or CAP_SYS_NICE and
+CAP_IPC_LOCK (or suitable rlimits).
+
+Time to sleep is worked out from getNextRun, so millis( ) and micros( ) must
+come from same clock (as they do on Arduino cores for Linux).
+
+Each wake up records how late the thread woke compared to time asked for in
+Stats wakeLatency and wakeMax, so OS latency can be told apart from tasks
+running too long (maxExec) or late scheduling (overdue). As the thread sleeps
+past MIN_TASK_INTERVAL when no task is due, overdue includes that time, unless
+ENABLE_ADAPTIVE_TICK is used where overdue is from when the pass was due and
+the thread sleeps until then without working out next run each time.
+
+With ENABLE_LINUX_EPOLL as well, tasks can be bound to file descriptors
+(sockets, pipes, serial ports...). The thread waits in epoll on bound file
+descriptors and a timerfd set to the next due time, when a file descriptor is
+ready its task is made due by Trigger and run straight away, so no polling
+from tasks is needed. Tasks are still normal tasks that are also run at their
+interval (which can be used as a time out). As epoll is level triggered a
+task must read all waiting data or it will be run again straight away.
+When a file descriptor is ready for a task that is stopped or held by
+groupSuspend the Trigger fails, so the file descriptor is taken out of epoll
+(parked) rather than waking the thread again straight away. After each pass
+parked file descriptors of tasks started again (and not held) are put back
+and their waiting data then runs the task. Up to _RT_FDS file descriptors
+can be bound.
+
+Functions
+---------
+RunThread   Start scheduler thread (call after Init)
+StopThread  Stop scheduler thread and wait for it to finish
+bindFD      Run a task when file descriptor is ready (ENABLE_LINUX_EPOLL)
+unbindFD    Remove file descriptor (ENABLE_LINUX_EPOLL)
+
+Tasks run on the scheduler thread, anything from other threads (like Start)
+has same rules as calling from interrupts. Trigger (and so Mailbox posts
+with a wake task) from another thread wakes the scheduler thread, writing
+an eventfd in its epoll set with ENABLE_LINUX_EPOLL or signalling the
+condition variable it sleeps on without, so the task runs within wake up
+latency of the OS rather than at the next due time or maxSleep. Without
+ENABLE_LINUX_EPOLL do not Trigger from signal handlers (condition variables
+are not async signal safe), eventfd is.
+*/
+#include <Arduino.h>
+#include "Schedule.h"
+
+#if defined( __linux__ ) && defined( ENABLE_LINUX_RT )
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#ifdef ENABLE_LINUX_EPOLL
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#endif
+
+// Stack size of scheduler thread and amount of it to prefault
+#define _RT_STACK   ( 256 * 1024 )
+#define _RT_PREFAULT ( 64 * 1024 )
+#ifdef ENABLE_LINUX_EPOLL
+// Number of events to get from each epoll_wait, and event data for timer
+// and wake eventfd
+#define _RT_EVENTS  16
+#define _RT_TIMER   0xFFFFFFFF
+#define _RT_WAKE    0xFFFFFFFE
+// Number of file descriptors that can be bound
+#define _RT_FDS     16
+#endif
+
+extern struct Stats stats;
+
+pthread_t rtThread;
+struct RTConfig rtConfig;
+volatile int rtRunning = 0;
+#ifdef ENABLE_LINUX_EPOLL
+int epollFD = -1;
+int timerFD = -1;
+int wakeFD = -1;                // eventfd written by rtWake
+
+// Bound file descriptors, state 0 free, 1 in epoll, 2 parked
+struct FDBind {
+              int fd;
+              int ID;
+              unsigned int events;
+              int state;
+              };
+struct FDBind fdTable[ _RT_FDS ];
+volatile int fdParked = 0;
+pthread_mutex_t fdLock = PTHREAD_MUTEX_INITIALIZER;
+#else
+// Thread sleeps on condition variable (CLOCK_MONOTONIC) set by rtWake
+pthread_mutex_t wakeLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t wakeCond;
+int wakeReady = 0;              // wakeCond made
+int wakeFlag = 0;               // woken, with wakeLock held
+#endif
+
+
+/* prefault - Touch stack so pages are in memory before running tasks */
+void prefault( )
+{
+volatile unsigned char stack[ _RT_PREFAULT ];
+
+memset( (void *)stack, 0, sizeof( stack ) );
+}
+
+
+/* wakeStats - Save how late thread woke up compared to target time */
+void wakeStats( const struct timespec *target )
+{
+#ifndef DISABLE_STATS
+struct timespec now;
+long late;
+
+clock_gettime( CLOCK_MONOTONIC, &now );
+late = ( now.tv_sec - target->tv_sec ) * 1000000
+       + ( now.tv_nsec - target->tv_nsec ) / 1000;
+if( late < 0 )
+  late = 0;
+stats.wakeLatency = late;
+if( stats.wakeLatency > stats.wakeMax )
+  stats.wakeMax = stats.wakeLatency;
+#endif
+}
+
+
+#ifdef ENABLE_LINUX_EPOLL
+/* epollClose - Close epoll, timerfd and eventfd made by epollInit */
+void epollClose( )
+{
+if( wakeFD >= 0 )
+  close( wakeFD );
+if( timerFD >= 0 )
+  close( timerFD );
+if( epollFD >= 0 )
+  close( epollFD );
+wakeFD = -1;
+timerFD = -1;
+epollFD = -1;
+}
+
+
+/* epollInit - Create epoll, timerfd and wake eventfd if not already done
+   Returns  int < 0 failed
+                  1 ready
+*/
+int epollInit( )
+{
+struct epoll_event event;
+
+if( epollFD >= 0 )
+  return 1;
+epollFD = epoll_create1( EPOLL_CLOEXEC );
+if( epollFD < 0 )
+  return -1;
+timerFD = timerfd_create( CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK );
+event.events = EPOLLIN;
+event.data.u64 = _RT_TIMER;
+if( timerFD < 0 || epoll_ctl( epollFD, EPOLL_CTL_ADD, timerFD, &event ) != 0 )
+  {
+  epollClose( );
+  return -1;
+  }
+wakeFD = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+event.events = EPOLLIN;
+event.data.u64 = _RT_WAKE;
+if( wakeFD < 0 || epoll_ctl( epollFD, EPOLL_CTL_ADD, wakeFD, &event ) != 0 )
+  {
+  epollClose( );
+  return -1;
+  }
+return 1;
+}
+
+
+/* fdAdd - Put bound file descriptor in epoll
+   Event data is slot in low 32 bits and task ID in high 32 bits
+   Call with fdLock held
+
+   Parameters  int slot in fdTable
+   Returns  int  0 failed (see errno)
+                 1 added
+*/
+int fdAdd( int slot )
+{
+struct epoll_event event;
+
+event.events = fdTable[ slot ].events;
+event.data.u64 = (uint32_t)slot | ( (uint64_t)fdTable[ slot ].ID << 32 );
+return epoll_ctl( epollFD, EPOLL_CTL_ADD, fdTable[ slot ].fd, &event ) == 0;
+}
+
+
+/* fdPark - Take file descriptor out of epoll as its task cannot be Triggered
+   Parameters  int slot in fdTable
+               int Task ID the event was for (slot may have been bound again)
+*/
+void fdPark( int slot, int ID )
+{
+pthread_mutex_lock( &fdLock );
+if( fdTable[ slot ].state == 1 && fdTable[ slot ].ID == ID
+    && epoll_ctl( epollFD, EPOLL_CTL_DEL, fdTable[ slot ].fd, NULL ) == 0 )
+  {
+  fdTable[ slot ].state = 2;
+  fdParked++;
+  }
+pthread_mutex_unlock( &fdLock );
+}
+
+
+/* fdUnpark - Put back parked file descriptors of tasks that can now run
+   Called after each pass when any are parked
+*/
+void fdUnpark( )
+{
+int i, ID;
+
+pthread_mutex_lock( &fdLock );
+for( i = 0; i < _RT_FDS && fdParked; i++ )
+   if( fdTable[ i ].state == 2 )
+     {
+     ID = fdTable[ i ].ID;
+     if( getStatus( ID ) <= 0 )
+       continue;
+#ifdef ENABLE_GROUPS
+     if( getSuspended( ID ) )
+       continue;
+#endif
+     if( fdAdd( i ) )
+       {
+       fdTable[ i ].state = 1;
+       fdParked--;
+       }
+     }
+pthread_mutex_unlock( &fdLock );
+}
+#endif
+
+
+/* rtWake - Wake scheduler thread from its sleep, called by Trigger
+   Does nothing when thread is not running, or when called on it (from a
+   task) as getNextRun then sees the Trigger and it does not sleep
+*/
+void rtWake( )
+{
+#ifdef ENABLE_LINUX_EPOLL
+uint64_t one = 1;
+#endif
+
+if( !rtRunning || pthread_equal( pthread_self( ), rtThread ) )
+  return;
+#ifdef ENABLE_LINUX_EPOLL
+// only fails when count is full, thread is being woken anyway
+if( write( wakeFD, &one, sizeof( one ) ) < 0 )
+  return;
+#else
+pthread_mutex_lock( &wakeLock );
+wakeFlag = 1;
+pthread_cond_signal( &wakeCond );
+pthread_mutex_unlock( &wakeLock );
+#endif
+}
+
+
+/* rtSleep - Sleep until target time or woken by rtWake
+   With ENABLE_LINUX_EPOLL wait for target time, wake eventfd or a bound
+   file descriptor ready, Trigger tasks of ready file descriptors. Without
+   wait on condition variable so a wake while running a pass (flag left
+   set) means no sleep.
+
+   Parameters  long time to sleep in us, 0 or less do not sleep
+*/
+void rtSleep( long wait )
+{
+struct timespec target;
+
+clock_gettime( CLOCK_MONOTONIC, &target );
+target.tv_nsec += wait * 1000;
+target.tv_sec += target.tv_nsec / 1000000000;
+target.tv_nsec %= 1000000000;
+#ifdef ENABLE_LINUX_EPOLL
+struct epoll_event events[ _RT_EVENTS ];
+struct itimerspec timer;
+uint64_t expired;
+int i, qty, ID;
+
+if( wait > 0 )
+  {
+  timer.it_interval.tv_sec = 0;
+  timer.it_interval.tv_nsec = 0;
+  timer.it_value = target;
+  timerfd_settime( timerFD, TFD_TIMER_ABSTIME, &timer, NULL );
+  }
+qty = epoll_wait( epollFD, events, _RT_EVENTS, wait > 0 ? -1 : 0 );
+for( i = 0; i < qty; i++ )
+   if( events[ i ].data.u64 == _RT_TIMER )
+     {
+     if( read( timerFD, &expired, sizeof( expired ) ) > 0 )
+       wakeStats( &target );
+     }
+   else if( events[ i ].data.u64 == _RT_WAKE )
+     {
+     // woken by Trigger from another thread, clear count for next time
+     if( read( wakeFD, &expired, sizeof( expired ) ) < 0 )
+       continue;
+     }
+   else
+     {
+     // stopped or held task, park so the thread does not spin on it
+     ID = (int)( events[ i ].data.u64 >> 32 );
+     if( Trigger( ID ) < 0 )
+       fdPark( (int)(uint32_t)events[ i ].data.u64, ID );
+     }
+#else
+int result, woken;
+
+if( wait > 0 )
+  {
+  result = 0;
+  pthread_mutex_lock( &wakeLock );
+  while( !wakeFlag && result != ETIMEDOUT )
+    result = pthread_cond_timedwait( &wakeCond, &wakeLock, &target );
+  woken = wakeFlag;
+  wakeFlag = 0;
+  pthread_mutex_unlock( &wakeLock );
+  if( !woken )
+    wakeStats( &target );
+  }
+#endif
+}
+
+
+/* rtLoop - Scheduler thread
+   Sleep until next time Run has something to do then call Run
+*/
+void *rtLoop( void * )
+{
+long wait;
+
+if( rtConfig.lockMemory )
+  prefault( );
+while( rtRunning )
+  {
+  // time to sleep in us, allowing for part of ms already gone
+  wait = (long)( getNextRun( ) * 1000 - micros( ) );
+  if( wait > (long)rtConfig.maxSleep * 1000 )
+    wait = (long)rtConfig.maxSleep * 1000;
+  rtSleep( wait );
+  Run( );
+#ifdef ENABLE_LINUX_EPOLL
+  if( fdParked )
+    fdUnpark( );
+#endif
+  }
+return NULL;
+}
+
+
+/* RunThread - Start scheduler thread
+   Call after Init, then loop( ) is free for other things (or nothing)
+
+    Parameters  pointer to settings (copied), NULL for defaults of
+                normal priority, any CPU, no locking, maxSleep 100 ms
+
+    Return int  -4  Could not lock memory
+                -3  Could not set CPU
+                -2  Could not set priority (permissions)
+                -1  Already running or could not create thread
+                 1  Thread running
+*/
+int RunThread( const struct RTConfig *config )
+{
+pthread_attr_t attr;
+struct sched_param param;
+cpu_set_t cpus;
+int i, result;
+#ifdef ENABLE_LINUX_EPOLL
+int created;
+#endif
+
+if( rtRunning )
+  return -1;
+if( config != NULL )
+  rtConfig = *config;
+else
+  {
+  rtConfig.priority = 0;
+  rtConfig.cpu = -1;
+  rtConfig.lockMemory = 0;
+  rtConfig.maxSleep = 100;
+  }
+if( rtConfig.maxSleep < 1 )
+  rtConfig.maxSleep = 1;
+
+pthread_attr_init( &attr );
+pthread_attr_setstacksize( &attr, _RT_STACK );
+if( rtConfig.priority > 0 )
+  {
+  pthread_attr_setinheritsched( &attr, PTHREAD_EXPLICIT_SCHED );
+  pthread_attr_setschedpolicy( &attr, SCHED_FIFO );
+  param.sched_priority = rtConfig.priority;
+  if( pthread_attr_setschedparam( &attr, &param ) != 0 )
+    {
+    pthread_attr_destroy( &attr );
+    return -2;
+    }
+  }
+if( rtConfig.cpu >= 0 )
+  {
+  CPU_ZERO( &cpus );
+  CPU_SET( rtConfig.cpu, &cpus );
+  if( pthread_attr_setaffinity_np( &attr, sizeof( cpus ), &cpus ) != 0 )
+    {
+    pthread_attr_destroy( &attr );
+    return -3;
+    }
+  }
+// Nothing to undo for bad settings, so only now take resources
+#ifdef ENABLE_LINUX_EPOLL
+created = ( epollFD < 0 );      // not made earlier by bindFD
+if( epollInit( ) < 0 )
+  {
+  pthread_attr_destroy( &attr );
+  return -1;
+  }
+#else
+if( !wakeReady )               // sleep and wake times use CLOCK_MONOTONIC
+  {
+  pthread_condattr_t condAttr;
+
+  pthread_condattr_init( &condAttr );
+  pthread_condattr_setclock( &condAttr, CLOCK_MONOTONIC );
+  pthread_cond_init( &wakeCond, &condAttr );
+  pthread_condattr_destroy( &condAttr );
+  wakeReady = 1;
+  }
+wakeFlag = 0;
+#endif
+if( rtConfig.lockMemory && mlockall( MCL_CURRENT | MCL_FUTURE ) != 0 )
+  result = -4;
+else
+  {
+  rtRunning = 1;
+  i = pthread_create( &rtThread, &attr, rtLoop, NULL );
+  if( i == 0 )
+    result = 1;
+  else
+    {
+    rtRunning = 0;
+    if( rtConfig.lockMemory )
+      munlockall( );
+    if( i == EPERM )
+      result = -2;
+    else
+      if( i == EINVAL && rtConfig.cpu >= 0 )
+        result = -3;
+      else
+        result = -1;
+    }
+  }
+pthread_attr_destroy( &attr );
+#ifdef ENABLE_LINUX_EPOLL
+if( result < 0 && created )
+  epollClose( );
+#endif
+return result;
+}
+
+
+/* StopThread - Stop scheduler thread
+   Waits for current pass to finish
+
+    Parameters  None
+
+    Return int  -1  Not running
+                 1  Stopped
+*/
+int StopThread( )
+{
+if( !rtRunning )
+  return -1;
+rtRunning = 0;
+pthread_join( rtThread, NULL );
+if( rtConfig.lockMemory )
+  munlockall( );
+return 1;
+}
+
+
+#ifdef ENABLE_LINUX_EPOLL
+/* bindFD - Run a task when a file descriptor is ready
+   Task must be started to be run, see Trigger. One task per file descriptor
+   but a task can have more than one file descriptor. Binding a file
+   descriptor again changes its task and events.
+
+    Parameters  int Task ID to run
+                int file descriptor
+                unsigned int epoll events to wait for (e.g. EPOLLIN)
+
+    Return int  -3  too many file descriptors (_RT_FDS)
+                -2  epoll failed (see errno)
+                -1  invalid ID
+                 1  bound
+*/
+int bindFD( int ID, int fd, unsigned int events )
+{
+int i, slot, result;
+
+if( ID < 0 || ID >= (int)_MAX_TASKS )
+  return -1;
+if( epollInit( ) < 0 )
+  return -2;
+pthread_mutex_lock( &fdLock );
+slot = -1;
+for( i = 0; i < _RT_FDS; i++ )
+   if( fdTable[ i ].state && fdTable[ i ].fd == fd )
+     {
+     slot = i;
+     break;
+     }
+   else
+     if( !fdTable[ i ].state && slot < 0 )
+       slot = i;
+if( slot < 0 )
+  result = -3;
+else
+  {
+  // take out first, so bound again same as new
+  if( fdTable[ slot ].state == 1 )
+    epoll_ctl( epollFD, EPOLL_CTL_DEL, fd, NULL );
+  if( fdTable[ slot ].state == 2 )
+    fdParked--;
+  fdTable[ slot ].fd = fd;
+  fdTable[ slot ].ID = ID;
+  fdTable[ slot ].events = events;
+  fdTable[ slot ].state = fdAdd( slot ) ? 1 : 0;
+  result = fdTable[ slot ].state ? 1 : -2;
+  }
+pthread_mutex_unlock( &fdLock );
+return result;
+}
+
+
+/* unbindFD - Stop running task when file descriptor is ready
+   Must be done BEFORE closing file descriptor
+
+    Parameters  int file descriptor
+
+    Return int  -1  not bound
+                 1  removed
+*/
+int unbindFD( int fd )
+{
+int i, result;
+
+result = -1;
+pthread_mutex_lock( &fdLock );
+for( i = 0; i < _RT_FDS; i++ )
+   if( fdTable[ i ].state && fdTable[ i ].fd == fd )
+     {
+     if( fdTable[ i ].state == 1 )
+       epoll_ctl( epollFD, EPOLL_CTL_DEL, fd, NULL );
+     else
+       fdParked--;
+     fdTable[ i ].state = 0;
+     result = 1;
+     break;
+     }
+pthread_mutex_unlock( &fdLock );
+return result;
+}
+#endif
+#endif
@@ -0,0 +1,149 @@
+/* Co-operative Scheduler shared memory statistics for Linux hosts
+
+Author: Paul Carpenter, PC Services, <sales@pcserviceselectronics.co.uk>
+
+Only built on Linux with ENABLE_LINUX_SHM defined in Tasklist.h, on other
+platforms this file compiles to nothing so can stay in sketch folder.
+
+Publishes task table, statistics and per task run counts at the end of every
+pass into a POSIX shared memory segment (/dev/shm/name), so other programs
+(see tools/schedtop.cpp) can watch the scheduler live without the scheduler
+printing anything. Cost to the scheduler is one copy of the table per pass.
+
+Layout of segment is in ScheduleShm.h, protected by a seqlock so the
+scheduler never waits for readers.
+
+Functions
+---------
+shmOpen     Create shared memory segment and start publishing
+shmClose    Stop publishing and remove segment
+*/
+#include <Arduino.h>
+#include "Schedule.h"
+
+#if defined( __linux__ ) && defined( ENABLE_LINUX_SHM )
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "ScheduleShm.h"
+
+#ifndef DISABLE_STATS
+extern struct Stats stats;
+#endif
+extern unsigned long taskRuns[ ];
+#ifdef ENABLE_COMPACT
+extern unsigned long taskNext( int );
+#endif
+
+struct ShmHeader *shm = NULL;   // segment NULL if not publishing
+struct ShmTask *shmTasks;       // task details in segment
+unsigned long shmSize;
+char shmName[ 64 ];
+
+
+/* shmPublish - Copy task table and statistics to segment
+   Called from Run at end of pass
+*/
+void shmPublish( )
+{
+int i;
+uint32_t seq;
+
+if( shm == NULL )
+  return;
+seq = shm->seq;
+__atomic_store_n( &shm->seq, seq + 1, __ATOMIC_RELAXED );
+__atomic_thread_fence( __ATOMIC_RELEASE );
+for( i = 0; i < (int)_MAX_TASKS; i++ )
+   {
+#ifdef ENABLE_COMPACT
+   shmTasks[ i ].next = taskNext( i );
+#else
+   shmTasks[ i ].next = taskTable[ i ].next;
+#endif
+   shmTasks[ i ].last = taskTable[ i ].last;
+   shmTasks[ i ].status = taskTable[ i ].status;
+   shmTasks[ i ].interval = taskTable[ i ].interval;
+   shmTasks[ i ].executed = taskTable[ i ].executed;
+   shmTasks[ i ].runs = taskRuns[ i ];
+   }
+#ifndef DISABLE_STATS
+shm->stats.start = stats.start;
+shm->stats.finish = stats.finish;
+shm->stats.maxExec = stats.maxExec;
+shm->stats.maxID = stats.maxID;
+shm->stats.qty = stats.qty;
+shm->stats.overdue = stats.overdue;
+shm->stats.overdueMax = stats.overdueMax;
+shm->stats.overdueAvg = stats.overdueAvg;
+shm->stats.maxLoop = stats.maxLoop;
+#endif
+shm->stats.passes++;
+__atomic_store_n( &shm->seq, seq + 2, __ATOMIC_RELEASE );
+}
+
+
+/* shmOpen - Create shared memory segment and start publishing
+   Segment is created or replaced, readable by all users
+
+    Parameters  name of segment must start with '/' e.g. "/scheduler"
+
+    Return int  -2  Could not create segment (see errno)
+                -1  Already open or invalid name
+                 1  Publishing
+*/
+int shmOpen( const char *name )
+{
+int fd;
+void *ptr;
+
+if( shm != NULL || name == NULL || name[ 0 ] != '/' || strlen( name ) >= sizeof( shmName ) )
+  return -1;
+shmSize = sizeof( struct ShmHeader ) + _MAX_TASKS * sizeof( struct ShmTask );
+fd = shm_open( name, O_CREAT | O_RDWR, 0644 );
+if( fd < 0 )
+  return -2;
+if( ftruncate( fd, shmSize ) != 0 )
+  {
+  close( fd );
+  return -2;
+  }
+ptr = mmap( NULL, shmSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+close( fd );
+if( ptr == MAP_FAILED )
+  return -2;
+memset( ptr, 0, shmSize );
+strcpy( shmName, name );
+shmTasks = (struct ShmTask *)( (struct ShmHeader *)ptr + 1 );
+( (struct ShmHeader *)ptr )->version = SHM_VERSION;
+( (struct ShmHeader *)ptr )->size = shmSize;
+( (struct ShmHeader *)ptr )->tasks = _MAX_TASKS;
+( (struct ShmHeader *)ptr )->pid = getpid( );
+#ifdef ENABLE_CYCLE_CLOCK
+( (struct ShmHeader *)ptr )->clockNs = 1;
+#endif
+__atomic_store_n( &( (struct ShmHeader *)ptr )->magic, SHM_MAGIC, __ATOMIC_RELEASE );
+shm = (struct ShmHeader *)ptr;
+return 1;
+}
+
+
+/* shmClose - Stop publishing and remove segment
+   Readers with segment open keep last copy
+
+    Return int  -1  Not open
+                 1  Closed
+*/
+int shmClose( )
+{
+void *ptr;
+
+if( shm == NULL )
+  return -1;
+ptr = shm;
+shm = NULL;
+munmap( ptr, shmSize );
+shm_unlink( shmName );
+return 1;
+}
+#endif
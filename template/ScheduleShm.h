@@ -0,0 +1,61 @@
+/* Co-operative Scheduler shared memory statistics layout
+
+   Layout of shared memory segment written by ScheduleShm.cpp on Linux hosts
+   and read by external monitors like tools/schedtop.cpp
+
+   Fixed size types only so monitor does not need same Tasklist.h settings,
+   change SHM_VERSION if layout changes.
+
+   Segment is
+
+        struct ShmHeader
+        struct ShmTask      one for each task ( header.tasks )
+
+   Seqlock - writer makes seq odd before writing and even after, readers copy
+   everything and only use copy if seq was the same even value before and
+   after copying.
+*/
+#ifndef SCHEDULESHM_H
+#define SCHEDULESHM_H
+
+#include <stdint.h>
+
+#define SHM_MAGIC   0x44484353UL    // "SCHD"
+#define SHM_VERSION 1
+
+// Per task details
+struct ShmTask  {
+                uint32_t next;      // next execution time in ms
+                uint32_t last;      // last execution time in us (ns)
+                int32_t status;     // current task status
+                int32_t interval;   // interval between starts in ms
+                int32_t executed;   // did run last pass = 1
+                uint32_t runs;      // times run since segment opened
+                };
+
+// Scheduler statistics
+struct ShmStats {
+                uint32_t start;     // pass start time (ms)
+                uint32_t finish;    // pass end time (ms)
+                uint32_t maxExec;   // maximum execution time (us or ns)
+                int32_t maxID;      // Task with maximum execution time
+                uint32_t qty;       // number of tasks run last pass
+                uint32_t overdue;   // overdue time last pass
+                uint32_t overdueMax;// largest overdue time
+                uint32_t overdueAvg;// Average overdue time
+                uint32_t maxLoop;   // Longest schedule loop time (ms or ns)
+                uint32_t passes;    // passes since segment opened
+                };
+
+struct ShmHeader {
+                uint32_t magic;     // SHM_MAGIC
+                uint32_t version;   // SHM_VERSION
+                uint32_t size;      // size of segment in bytes
+                uint32_t tasks;     // number of tasks
+                uint32_t pid;       // process writing segment
+                uint32_t clockNs;   // non zero last, maxExec and maxLoop
+                                    // are ns (ENABLE_CYCLE_CLOCK)
+                uint32_t seq;       // seqlock sequence odd = being written
+                struct ShmStats stats;
+                };
+#endif
@@ -0,0 +1,347 @@
+/* Co-operative Scheduler compact telemetry stream
+
+Author: Paul Carpenter, PC Services, <sales@pcserviceselectronics.co.uk>
+
+Only built with ENABLE_TELEMETRY defined in Tasklist.h, otherwise this file
+compiles to nothing so can stay in sketch folder.
+
+Printing the task table as text (like dumplog in SchedulerTest) sends every
+field of every task even when nothing changed, far too slow to do all the
+time over a serial port. This sends at the end of a pass (every pass or every
+interval ms) only the task and statistics fields that changed since the last
+frame, as small differences in a framed binary format (see ScheduleTele.h).
+A full keyframe is sent at start, every TELEMETRY_KEYFRAME frames and on
+teleKey so a receiver can join or recover at any time. tools/teledecode.cpp
+rebuilds the full table history on a host.
+
+Bytes are given to a send function of the sketch in blocks of up to 255 bytes
+as they are made, so only one block is buffered e.g.
+
+    void teleSend( const unsigned char *data, unsigned int length )
+    {
+    Serial.write( data, length );
+    }
+
+    teleStart( teleSend, 100 );
+
+Send function is called from Run, keep it short (room in serial buffer) or
+frames add to pass time.
+
+Functions
+---------
+teleStart   Start sending frames
+teleStop    Stop sending frames
+teleKey     Send keyframe next frame
+*/
+#include <Arduino.h>
+#include "Schedule.h"
+
+#ifdef ENABLE_TELEMETRY
+#include "ScheduleTele.h"
+
+#ifndef DISABLE_STATS
+extern struct Stats stats;
+#endif
+#ifdef ENABLE_COMPACT
+extern unsigned long taskNext( int );
+#endif
+
+void ( *teleSend )( const unsigned char *, unsigned int ) = NULL;
+unsigned int teleInterval;          // ms between frames, 0 every pass
+unsigned long teleLast;             // time of last frame (ms)
+unsigned int teleFrames;            // frames until keyframe, 0 next
+unsigned char teleSeq;
+unsigned char teleCRC8;
+unsigned char teleBlock[ 255 ];     // COBS block being made
+unsigned char teleCount;            // next byte in block
+
+// Values in last frame sent
+uint32_t telePrev[ _MAX_TASKS ][ TELE_TASK_FIELDS ];
+#ifndef DISABLE_STATS
+uint32_t telePrevStats[ TELE_STAT_FIELDS ];
+#endif
+
+// Flags of fields sent for these settings
+#ifdef ENABLE_STAGGER
+#define _TELE_PHASE         TELE_HAS_PHASE
+#else
+#define _TELE_PHASE         0
+#endif
+#ifdef ENABLE_BACKGROUND
+#define _TELE_BACKGROUND    TELE_HAS_BACKGROUND
+#else
+#define _TELE_BACKGROUND    0
+#endif
+#ifdef ENABLE_PASS_BUDGET
+#define _TELE_BUDGET        TELE_HAS_BUDGET
+#else
+#define _TELE_BUDGET        0
+#endif
+#ifdef ENABLE_ADAPTIVE_TICK
+#define _TELE_TICK          TELE_HAS_TICK
+#else
+#define _TELE_TICK          0
+#endif
+#ifdef ENABLE_DEGRADE
+#define _TELE_DEGRADE       TELE_HAS_DEGRADE
+#else
+#define _TELE_DEGRADE       0
+#endif
+#ifdef ENABLE_LINUX_RT
+#define _TELE_RT            TELE_HAS_RT
+#else
+#define _TELE_RT            0
+#endif
+#ifndef DISABLE_STATS
+#define _TELE_STATS         TELE_HAS_STATS
+#else
+#define _TELE_STATS         0
+#endif
+#define _TELE_FLAGS ( _TELE_STATS | _TELE_PHASE | _TELE_BACKGROUND | _TELE_BUDGET \
+                      | _TELE_TICK | _TELE_DEGRADE | _TELE_RT )
+
+
+/* teleByte - Add byte to frame, COBS encoded
+   Sends block when full or at a 0x00
+*/
+void teleByte( unsigned char data )
+{
+if( data == 0 )
+  {
+  teleBlock[ 0 ] = teleCount;
+  teleSend( teleBlock, teleCount );
+  teleCount = 1;
+  return;
+  }
+teleBlock[ teleCount++ ] = data;
+if( teleCount == 255 )
+  {
+  teleBlock[ 0 ] = 255;             // 254 bytes no 0x00 after
+  teleSend( teleBlock, 255 );
+  teleCount = 1;
+  }
+}
+
+
+/* telePut - Add byte of frame contents and to CRC */
+void telePut( unsigned char data )
+{
+teleCRC8 = teleCRC( teleCRC8, data );
+teleByte( data );
+}
+
+
+/* teleVarint - Add value low 7 bits first, top bit set if more bytes */
+void teleVarint( uint32_t value )
+{
+while( value > 0x7F )
+  {
+  telePut( (unsigned char)( value | 0x80 ) );
+  value >>= 7;
+  }
+telePut( (unsigned char)value );
+}
+
+
+/* teleDelta - Add difference from last value as zigzag varint */
+void teleDelta( uint32_t value, uint32_t prev )
+{
+uint32_t delta;
+
+delta = value - prev;
+teleVarint( ( delta << 1 ) ^ ( ( delta & 0x80000000UL ) ? 0xFFFFFFFFUL : 0 ) );
+}
+
+
+/* teleTask - Get fields of task in order sent */
+void teleTask( int ID, uint32_t *value )
+{
+#ifdef ENABLE_COMPACT
+value[ 0 ] = taskNext( ID );
+#else
+value[ 0 ] = taskTable[ ID ].next;
+#endif
+value[ 1 ] = taskTable[ ID ].last;
+value[ 2 ] = taskTable[ ID ].status;
+value[ 3 ] = taskTable[ ID ].interval;
+value[ 4 ] = taskTable[ ID ].executed;
+#ifdef ENABLE_STAGGER
+value[ 5 ] = taskTable[ ID ].phase;
+#else
+value[ 5 ] = 0;
+#endif
+}
+
+
+#ifndef DISABLE_STATS
+/* teleStats - Get statistics in order sent
+   Returns     unsigned long mask of statistics for these settings
+*/
+uint32_t teleStats( uint32_t *value )
+{
+uint32_t mask;
+
+mask = 0x1FF;
+value[ 0 ] = stats.start;
+value[ 1 ] = stats.finish;
+value[ 2 ] = stats.maxExec;
+value[ 3 ] = stats.maxID;
+value[ 4 ] = stats.qty;
+value[ 5 ] = stats.overdue;
+value[ 6 ] = stats.overdueMax;
+value[ 7 ] = stats.overdueAvg;
+value[ 8 ] = stats.maxLoop;
+#ifdef ENABLE_BACKGROUND
+value[ 9 ] = stats.slackUsed;
+value[ 10 ] = stats.bgQty;
+mask |= 0x600;
+#endif
+#ifdef ENABLE_PASS_BUDGET
+value[ 11 ] = stats.budgetHits;
+mask |= 0x800;
+#endif
+#ifdef ENABLE_ADAPTIVE_TICK
+value[ 12 ] = stats.tick;
+mask |= 0x1000;
+#endif
+#ifdef ENABLE_DEGRADE
+value[ 13 ] = stats.degraded;
+value[ 14 ] = stats.degrades;
+value[ 15 ] = stats.restores;
+mask |= 0xE000;
+#endif
+#ifdef ENABLE_LINUX_RT
+value[ 16 ] = stats.wakeLatency;
+value[ 17 ] = stats.wakeMax;
+mask |= 0x30000;
+#endif
+return mask;
+}
+#endif
+
+
+/* telePublish - Send frame of changes if time to
+   Called from Run at end of pass
+*/
+void telePublish( )
+{
+int ID, i, gap;
+unsigned char key, mask;
+uint32_t value[ TELE_TASK_FIELDS ];
+#ifndef DISABLE_STATS
+uint32_t statValue[ TELE_STAT_FIELDS ], statMask, sendMask;
+#endif
+
+if( teleSend == NULL )
+  return;
+if( teleInterval && millis( ) - teleLast < teleInterval )
+  return;
+teleLast = millis( );
+key = ( teleFrames == 0 );
+if( key )
+  {
+  teleFrames = TELEMETRY_KEYFRAME;
+  memset( telePrev, 0, sizeof( telePrev ) );
+#ifndef DISABLE_STATS
+  memset( telePrevStats, 0, sizeof( telePrevStats ) );
+#endif
+  }
+teleFrames--;
+teleCRC8 = 0;
+teleCount = 1;
+telePut( key ? TELE_KEY : TELE_DELTA );
+telePut( teleSeq++ );
+if( key )
+  {
+  telePut( TELE_VERSION );
+  telePut( _TELE_FLAGS );
+  teleVarint( _MAX_TASKS );
+  }
+
+#ifndef DISABLE_STATS
+statMask = teleStats( statValue );
+sendMask = 0;
+for( i = 0; i < TELE_STAT_FIELDS; i++ )
+   if( ( statMask & ( 1UL << i ) ) && ( key || statValue[ i ] != telePrevStats[ i ] ) )
+     sendMask |= 1UL << i;
+teleVarint( sendMask );
+for( i = 0; i < TELE_STAT_FIELDS; i++ )
+   if( sendMask & ( 1UL << i ) )
+     {
+     teleDelta( statValue[ i ], telePrevStats[ i ] );
+     telePrevStats[ i ] = statValue[ i ];
+     }
+#endif
+
+gap = -1;
+for( ID = 0; ID < (int)_MAX_TASKS; ID++ )
+   {
+   teleTask( ID, value );
+   mask = 0;
+   for( i = 0; i < TELE_TASK_FIELDS; i++ )
+      if( key || value[ i ] != telePrev[ ID ][ i ] )
+        mask |= 1 << i;
+   if( !_TELE_PHASE )
+     mask &= ~TELE_PHASE;
+   if( !mask )
+     continue;
+   teleVarint( ID - gap );
+   gap = ID;
+   telePut( mask );
+   for( i = 0; i < TELE_TASK_FIELDS; i++ )
+      if( mask & ( 1 << i ) )
+        {
+        teleDelta( value[ i ], telePrev[ ID ][ i ] );
+        telePrev[ ID ][ i ] = value[ i ];
+        }
+   }
+teleVarint( 0 );                    // end of tasks
+teleByte( teleCRC8 );
+
+// last block and end of frame
+teleBlock[ 0 ] = teleCount;
+teleBlock[ teleCount ] = 0;
+teleSend( teleBlock, teleCount + 1 );
+}
+
+
+/* teleStart - Start sending frames, first is a keyframe
+    Parameters  pointer to function that sends bytes
+                unsigned int ms between frames, 0 every pass
+
+    Return int  -1  No send function
+                 1  Sending
+*/
+int teleStart( void ( *send )( const unsigned char *, unsigned int ), unsigned int interval )
+{
+if( send == NULL )
+  return -1;
+teleInterval = interval;
+teleLast = millis( ) - interval;
+teleFrames = 0;
+teleSend = send;
+return 1;
+}
+
+
+/* teleStop - Stop sending frames
+    Return int  -1  Not sending
+                 1  Stopped
+*/
+int teleStop( )
+{
+if( teleSend == NULL )
+  return -1;
+teleSend = NULL;
+return 1;
+}
+
+
+/* teleKey - Send keyframe as next frame
+   e.g. when receiver connects
+*/
+void teleKey( )
+{
+teleFrames = 0;
+}
+#endif
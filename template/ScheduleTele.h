@@ -0,0 +1,80 @@
+/* Co-operative Scheduler telemetry stream format
+
+   Format of binary frames sent by ScheduleTele.cpp and read by host decoders
+   like tools/teledecode.cpp. Change TELE_VERSION if format changes.
+
+   Frames are COBS encoded so contain no 0x00 bytes and each ends with 0x00,
+   a receiver starting part way through or losing bytes just waits for the
+   next 0x00. Decoded a frame is
+
+        type        TELE_KEY full frame or TELE_DELTA changes only
+        seq         frame count (8 bits) to spot lost frames
+        keyframes only
+            version     TELE_VERSION
+            flags       TELE_HAS_... fields sent (from Tasklist.h settings)
+            tasks       varint number of tasks
+        if TELE_HAS_STATS
+            mask        varint one bit for each statistic sent, in order of
+                        struct Stats (see TELE_STAT_NAMES), then its value
+        tasks changed, in ID order
+            gap         varint ID - ID of previous task sent + 1 (first
+                        task sent ID + 1), 0 ends list
+            mask        byte TELE_NEXT... one bit for each field sent, then
+                        its value
+        crc         CRC-8 (polynomial 0x07) of all bytes before
+
+   All values are 32 bit, sent as difference from last value sent (0 in a
+   keyframe) as zigzag varint (low 7 bits first, top bit set if more bytes)
+   so small changes and wrapping times take one or two bytes. Deltas only
+   make sense after the keyframe and every frame since, on any lost frame
+   wait for next keyframe.
+*/
+#ifndef SCHEDULETELE_H
+#define SCHEDULETELE_H
+
+#include <stdint.h>
+
+#define TELE_VERSION    1
+
+// Frame types
+#define TELE_KEY        1
+#define TELE_DELTA      2
+
+// Flags in keyframe
+#define TELE_HAS_STATS      0x01
+#define TELE_HAS_PHASE      0x02    // ENABLE_STAGGER
+#define TELE_HAS_BACKGROUND 0x04    // ENABLE_BACKGROUND
+#define TELE_HAS_BUDGET     0x08    // ENABLE_PASS_BUDGET
+#define TELE_HAS_TICK       0x10    // ENABLE_ADAPTIVE_TICK
+#define TELE_HAS_DEGRADE    0x20    // ENABLE_DEGRADE
+#define TELE_HAS_RT         0x40    // ENABLE_LINUX_RT
+
+// Task fields in order sent
+#define TELE_NEXT       0x01
+#define TELE_LAST       0x02
+#define TELE_STATUS     0x04
+#define TELE_INTERVAL   0x08
+#define TELE_EXECUTED   0x10
+#define TELE_PHASE      0x20
+#define TELE_TASK_FIELDS    6
+
+// Statistics in order sent, ones not in flags are left out
+#define TELE_STAT_FIELDS    18
+#define TELE_STAT_NAMES { "start", "finish", "maxExec", "maxID", "qty", \
+                          "overdue", "overdueMax", "overdueAvg", "maxLoop", \
+                          "slackUsed", "bgQty", "budgetHits", "tick", \
+                          "degraded", "degrades", "restores", \
+                          "wakeLatency", "wakeMax" }
+
+
+/* teleCRC - Add byte to CRC-8 (polynomial 0x07, start 0) */
+static inline uint8_t teleCRC( uint8_t crc, uint8_t data )
+{
+int i;
+
+crc ^= data;
+for( i = 0; i < 8; i++ )
+   crc = ( crc & 0x80 ) ? ( crc << 1 ) ^ 0x07 : crc << 1;
+return crc;
+}
+#endif
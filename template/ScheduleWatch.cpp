@@ -0,0 +1,274 @@
+/* Co-operative Scheduler task watchdog for Linux hosts
+
+Author: Paul Carpenter, PC Services, <sales@pcserviceselectronics.co.uk>
+
+Only built on Linux with ENABLE_LINUX_WATCHDOG defined in Tasklist.h, on other
+platforms this file compiles to nothing so can stay in sketch folder.
+
+As tasks are co-operative a task that never returns stops everything, and a
+hardware or system watchdog reset gives no clue which task it was. This runs
+a monitor thread that every period looks at which task the scheduler thread
+is running and for how long
+
+    Longer than kill limit      logged as hung with task ID, status it was
+                                called with, time running and a stack trace
+                                of the scheduler thread, then optionally
+                                abort( ) (for core dump and restart by
+                                systemd or similar)
+
+Every run of a task longer than its warn limit is counted as an overrun by
+the scheduler itself when the task returns (once the monitor is started).
+Limits default to WATCH_WARN and WATCH_KILL us and can be set for each task.
+With stall set, Run not being called for that many ms when no task is
+running (loop( ) stuck elsewhere) is logged the same way.
+
+Stack trace is written by the scheduler thread itself from a SIGUSR2 handler
+using glibc backtrace, so SIGUSR2 must not be used by the sketch. Link with
+-rdynamic for function names in trace. Log is appended to so keeps history
+over restarts.
+
+Functions
+---------
+StartWatch      Start monitor thread (call from thread that calls Run, or
+                after RunThread)
+StopWatch       Stop monitor thread
+setWatchLimit   Set warn and kill limits of a task
+getOverruns     Get number of overruns of a task
+*/
+#include <Arduino.h>
+#include "Schedule.h"
+
+#if defined( __linux__ ) && defined( ENABLE_LINUX_WATCHDOG )
+#include <pthread.h>
+#include <signal.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+
+// Deepest stack trace and time to wait for it (ms)
+#define _WATCH_DEPTH    64
+#define _WATCH_DUMP     100
+
+// From Schedule.cpp
+extern volatile int watchID;
+extern volatile int watchStatus;
+extern volatile unsigned long watchStart;
+extern volatile unsigned long watchRuns;
+extern volatile unsigned long watchBeat;
+extern pthread_t watchThread;
+
+pthread_t monThread;
+struct WatchConfig watchConfig;
+volatile int watchRunning = 0;
+int watchLog = -1;              // log file descriptor
+volatile int watchDumped;       // stack trace written by signal handler
+unsigned long watchWarn[ _MAX_TASKS ];  // limits (us), 0 until started
+unsigned long watchKill[ _MAX_TASKS ];
+unsigned long watchOverruns[ _MAX_TASKS ];  // counted by runTask
+
+
+/* watchSignal - Write stack trace of scheduler thread to log
+   Signal handler run on scheduler thread
+*/
+void watchSignal( int )
+{
+void *trace[ _WATCH_DEPTH ];
+int depth;
+
+depth = backtrace( trace, _WATCH_DEPTH );
+backtrace_symbols_fd( trace, depth, watchLog );
+watchDumped = 1;
+}
+
+
+/* watchDump - Log problem with stack trace of scheduler thread
+   then abort if set to
+
+   Parameters  char * message already formatted
+*/
+void watchDump( const char *message )
+{
+int i;
+
+dprintf( watchLog, "scheduler watchdog: %s\nstack trace of scheduler thread:\n",
+         message );
+watchDumped = 0;
+if( pthread_kill( watchThread, SIGUSR2 ) == 0 )
+  for( i = 0; i < _WATCH_DUMP && !watchDumped; i++ )
+     usleep( 1000 );
+if( !watchDumped )
+  dprintf( watchLog, "  (not available)\n" );
+dprintf( watchLog, "\n" );
+fsync( watchLog );
+if( watchConfig.abortOnKill )
+  abort( );
+}
+
+
+/* watchLoop - Monitor thread
+   Checks task running and calls of Run every period
+*/
+void *watchLoop( void * )
+{
+unsigned long runs, beat, lastBeat, stallTime, elapsed, logged;
+int ID, status, stalled;
+char message[ 160 ];
+
+logged = ~0UL;
+stalled = 0;
+lastBeat = watchBeat;
+stallTime = millis( );
+while( watchRunning )
+  {
+  usleep( watchConfig.period * 1000 );
+  // consistent view of task running, same run before and after
+  runs = __atomic_load_n( &watchRuns, __ATOMIC_ACQUIRE );
+  ID = __atomic_load_n( &watchID, __ATOMIC_ACQUIRE );
+  status = watchStatus;
+  elapsed = micros( ) - watchStart;
+  if( runs != __atomic_load_n( &watchRuns, __ATOMIC_ACQUIRE ) )
+    continue;
+  if( ID >= 0 && ID < (int)_MAX_TASKS )
+    {
+    if( elapsed >= watchKill[ ID ] && logged != runs )
+      {
+      snprintf( message, sizeof( message ),
+                "task %d hung, called with status %d, running %lu us (limit %lu) at %lu ms, overruns %lu",
+                ID, status, elapsed, watchKill[ ID ], millis( ), watchOverruns[ ID ] );
+      watchDump( message );
+      logged = runs;
+      }
+    }
+  beat = watchBeat;
+  if( beat != lastBeat || ID >= 0 )
+    {
+    lastBeat = beat;
+    stallTime = millis( );
+    stalled = 0;
+    }
+  else
+    if( watchConfig.stall > 0 && !stalled
+        && millis( ) - stallTime >= (unsigned long)watchConfig.stall )
+      {
+      snprintf( message, sizeof( message ),
+                "Run not called for %lu ms, no task running, at %lu ms",
+                millis( ) - stallTime, millis( ) );
+      watchDump( message );
+      stalled = 1;                      // once until Run called again
+      }
+  }
+return NULL;
+}
+
+
+/* StartWatch - Start monitor thread
+   If Run is not called from a thread started by RunThread, call this from
+   the thread that calls Run, before first call of Run.
+
+    Parameters  pointer to settings (copied), NULL for defaults of
+                log to stderr, check every 10 ms, no stall check, no abort
+
+    Return int  -2  Could not open log file
+                -1  Already running or could not create thread
+                 1  Thread running
+*/
+int StartWatch( const struct WatchConfig *config )
+{
+struct sigaction action;
+void *trace[ 1 ];
+int i;
+
+if( watchRunning )
+  return -1;
+if( config != NULL )
+  watchConfig = *config;
+else
+  {
+  watchConfig.logFile = NULL;
+  watchConfig.period = 10;
+  watchConfig.stall = 0;
+  watchConfig.abortOnKill = 0;
+  }
+if( watchConfig.period < 1 )
+  watchConfig.period = 1;
+if( watchConfig.logFile == NULL )
+  watchLog = STDERR_FILENO;
+else
+  {
+  watchLog = open( watchConfig.logFile, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644 );
+  if( watchLog < 0 )
+    return -2;
+  }
+for( i = 0; i < (int)_MAX_TASKS; i++ )
+   {
+   if( watchWarn[ i ] == 0 )
+     watchWarn[ i ] = WATCH_WARN;
+   if( watchKill[ i ] == 0 )
+     watchKill[ i ] = WATCH_KILL;
+   }
+backtrace( trace, 1 );              // load unwinder now, not in handler
+action.sa_handler = watchSignal;
+sigemptyset( &action.sa_mask );
+action.sa_flags = SA_RESTART;
+sigaction( SIGUSR2, &action, NULL );
+watchThread = pthread_self( );      // until Run is called
+watchRunning = 1;
+if( pthread_create( &monThread, NULL, watchLoop, NULL ) != 0 )
+  {
+  watchRunning = 0;
+  return -1;
+  }
+return 1;
+}
+
+
+/* StopWatch - Stop monitor thread
+    Parameters  None
+
+    Return int  -1  Not running
+                 1  Stopped
+*/
+int StopWatch( )
+{
+if( !watchRunning )
+  return -1;
+watchRunning = 0;
+pthread_join( monThread, NULL );
+if( watchLog > STDERR_FILENO )
+  close( watchLog );
+watchLog = -1;
+return 1;
+}
+
+
+/* setWatchLimit - Set warn and kill limits of a task
+    Parameters  int Task ID
+                unsigned long run time counted as overrun (us), 0 default
+                unsigned long run time logged as hung (us), 0 default
+
+    Return int  -1  invalid ID
+                 1  set
+*/
+int setWatchLimit( int ID, unsigned long warn, unsigned long kill )
+{
+if( ID < 0 || ID >= (int)_MAX_TASKS )
+  return -1;
+watchWarn[ ID ] = warn ? warn : WATCH_WARN;
+watchKill[ ID ] = kill ? kill : WATCH_KILL;
+return 1;
+}
+
+
+/* getOverruns - Get number of runs of a task longer than warn limit
+    Parameters  int Task ID
+
+    Return      unsigned long count (0 for invalid ID)
+*/
+unsigned long getOverruns( int ID )
+{
+if( ID < 0 || ID >= (int)_MAX_TASKS )
+  return 0;
+return watchOverruns[ ID ];
+}
+#endif
@@ -0,0 +1,200 @@
+/* cyclicgen - Make cyclic executive tables for Co-operative Scheduler
+
+Author: Paul Carpenter, PC Services, <sales@pcserviceselectronics.co.uk>
+
+From the period of each task works out the hyperperiod (lowest common
+multiple of periods) and which tasks run in each minor frame of
+MIN_TASK_INTERVAL ms, then prints the tables to paste into Tasklist.h for
+ENABLE_CYCLIC. Run then just runs the tasks listed for each frame in turn.
+
+Each task is given an offset (first frame it runs in) to spread load over
+frames, shortest periods placed first, each in the frame offset that adds
+least to the busiest frame it runs in. Give execution times to balance by
+time rather than number of tasks. In each frame tasks run in ID order.
+
+Build
+    g++ -O2 -o cyclicgen cyclicgen.cpp
+
+Usage
+    cyclicgen min_interval period[:us] ...
+
+        min_interval    MIN_TASK_INTERVAL from Tasklist.h (ms)
+        period          period of task ID 0, 1, 2... in ms, must be a
+                        multiple of min_interval, 0 task never run
+        us              optional worst case execution time of task (us)
+
+    e.g. cyclicgen 10 10 20:500 40 0 100
+
+Periods that are all multiples of each other (harmonic) keep the tables
+short, others can make the hyperperiod very long.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+
+// Largest table sizes allowed
+#define MAX_FRAMES  65535
+#define MAX_ENTRIES 65535
+
+
+/* gcd - Greatest common divisor */
+unsigned long gcd( unsigned long a, unsigned long b )
+{
+unsigned long t;
+
+while( b )
+  {
+  t = a % b;
+  a = b;
+  b = t;
+  }
+return a;
+}
+
+
+int main( int argc, char *argv[ ] )
+{
+int tasks, i, j, best, timed, *order, *offset;
+unsigned long minInterval, frames, f, k, entries, load, sum, bestLoad, bestSum;
+unsigned long *period, *ticks, *cost, *frameLoad, maxLoad;
+char *end;
+
+if( argc < 3 )
+  {
+  fprintf( stderr, "usage: cyclicgen min_interval period[:us] ...\n" );
+  return 1;
+  }
+minInterval = strtoul( argv[ 1 ], &end, 10 );
+if( *end || minInterval < 1 || minInterval > 32767 )
+  {
+  fprintf( stderr, "cyclicgen: bad min_interval %s\n", argv[ 1 ] );
+  return 1;
+  }
+tasks = argc - 2;
+period = (unsigned long *)calloc( tasks, sizeof( unsigned long ) );
+ticks = (unsigned long *)calloc( tasks, sizeof( unsigned long ) );
+cost = (unsigned long *)calloc( tasks, sizeof( unsigned long ) );
+order = (int *)calloc( tasks, sizeof( int ) );
+offset = (int *)calloc( tasks, sizeof( int ) );
+
+// Read periods and work out hyperperiod in frames
+frames = 1;
+timed = 0;
+for( i = 0; i < tasks; i++ )
+   {
+   period[ i ] = strtoul( argv[ i + 2 ], &end, 10 );
+   cost[ i ] = 1;
+   if( *end == ':' )
+     {
+     cost[ i ] = strtoul( end + 1, &end, 10 );
+     timed = 1;
+     }
+   if( *end || period[ i ] > 32767 || period[ i ] % minInterval )
+     {
+     fprintf( stderr, "cyclicgen: task %d period %s not a multiple of %lu up to 32767\n",
+              i, argv[ i + 2 ], minInterval );
+     return 1;
+     }
+   ticks[ i ] = period[ i ] / minInterval;
+   if( ticks[ i ] )
+     {
+     frames = frames / gcd( frames, ticks[ i ] ) * ticks[ i ];
+     if( frames > MAX_FRAMES )
+       {
+       fprintf( stderr, "cyclicgen: hyperperiod over %d frames, use harmonic periods\n",
+                MAX_FRAMES );
+       return 1;
+       }
+     }
+   }
+
+// Place tasks shortest period first (then ID order)
+for( i = 0; i < tasks; i++ )
+   order[ i ] = i;
+for( i = 1; i < tasks; i++ )
+   for( j = i; j > 0 && ticks[ order[ j ] ] < ticks[ order[ j - 1 ] ]; j-- )
+      {
+      best = order[ j ];
+      order[ j ] = order[ j - 1 ];
+      order[ j - 1 ] = best;
+      }
+frameLoad = (unsigned long *)calloc( frames, sizeof( unsigned long ) );
+entries = 0;
+for( j = 0; j < tasks; j++ )
+   {
+   i = order[ j ];
+   offset[ i ] = -1;
+   if( !ticks[ i ] )
+     continue;
+   best = 0;
+   bestLoad = bestSum = ~0UL;
+   for( f = 0; f < ticks[ i ]; f++ )
+      {
+      load = sum = 0;
+      for( k = f; k < frames; k += ticks[ i ] )
+         {
+         sum += frameLoad[ k ];
+         if( frameLoad[ k ] > load )
+           load = frameLoad[ k ];
+         }
+      if( load < bestLoad || ( load == bestLoad && sum < bestSum ) )
+        {
+        best = (int)f;
+        bestLoad = load;
+        bestSum = sum;
+        }
+      }
+   offset[ i ] = best;
+   for( f = best; f < frames; f += ticks[ i ] )
+      frameLoad[ f ] += cost[ i ];
+   entries += frames / ticks[ i ];
+   }
+if( entries > MAX_ENTRIES )
+  {
+  fprintf( stderr, "cyclicgen: %lu table entries over %d\n", entries, MAX_ENTRIES );
+  return 1;
+  }
+maxLoad = 0;
+for( f = 0; f < frames; f++ )
+   if( frameLoad[ f ] > maxLoad )
+     maxLoad = frameLoad[ f ];
+
+// Tables and summary
+printf( "/* Cyclic executive tables made by cyclicgen" );
+for( i = 1; i < argc; i++ )
+   printf( " %s", argv[ i ] );
+printf( "\n   Hyperperiod %lu ms, %lu frames of %lu ms, busiest frame %lu %s\n",
+        frames * minInterval, frames, minInterval, maxLoad,
+        timed ? "us" : "tasks" );
+printf( "\n    ID  period  offset\n" );
+for( i = 0; i < tasks; i++ )
+   if( ticks[ i ] )
+     printf( "  %4d  %6lu  %6lu\n", i, period[ i ], offset[ i ] * minInterval );
+   else
+     printf( "  %4d       -   never\n", i );
+printf( "*/\n#define CYCLIC_FRAMES   %lu\n", frames );
+printf( "const unsigned int cyclicFrame[ CYCLIC_FRAMES + 1 ] = {" );
+entries = 0;
+for( f = 0; f <= frames; f++ )
+   {
+   printf( "%s%s%lu", f ? "," : "", f % 16 ? " " : "\n                ", entries );
+   if( f < frames )
+     for( i = 0; i < tasks; i++ )
+        if( ticks[ i ] && f % ticks[ i ] == (unsigned long)offset[ i ] )
+          entries++;
+   }
+printf( " };\nconst unsigned short cyclicTasks[ %lu ] = {", entries ? entries : 1 );
+entries = 0;
+for( f = 0; f < frames; f++ )
+   for( i = 0; i < tasks; i++ )
+      if( ticks[ i ] && f % ticks[ i ] == (unsigned long)offset[ i ] )
+        {
+        printf( "%s%s%d", entries ? "," : "", entries % 16 ? " " : "\n                ", i );
+        entries++;
+        }
+if( !entries )
+  printf( " 0" );
+printf( " };\n" );
+if( timed && maxLoad > minInterval * 1000 )
+  fprintf( stderr, "cyclicgen: warning busiest frame %lu us longer than frame\n", maxLoad );
+return 0;
+}
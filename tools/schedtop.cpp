@@ -0,0 +1,124 @@
+/* schedtop - Live view of Co-operative Scheduler on Linux host
+
+Author: Paul Carpenter, PC Services, <sales@pcserviceselectronics.co.uk>
+
+Reads shared memory segment published by template/ScheduleShm.cpp (build
+scheduler with ENABLE_LINUX_SHM and call shmOpen) and shows task table and
+statistics like top, runs per second worked out from run counts.
+
+Build
+    g++ -O2 -I../template -o schedtop schedtop.cpp -lrt
+
+Usage
+    schedtop [name [interval_ms]]
+
+        name        segment name as passed to shmOpen (default /scheduler)
+        interval_ms refresh time (default 1000)
+
+Ctrl-C to exit
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ScheduleShm.h"
+
+
+/* readSegment - Consistent copy of segment using seqlock
+   Parameters  pointer to segment
+               pointer to buffer for copy
+               size of segment
+
+   Returns     int  0 could not get consistent copy
+                    1 copy done
+*/
+int readSegment( const struct ShmHeader *shm, void *copy, size_t size )
+{
+uint32_t before, after;
+int tries;
+
+for( tries = 0; tries < 1000; tries++ )
+   {
+   before = __atomic_load_n( &shm->seq, __ATOMIC_ACQUIRE );
+   if( before & 1 )
+     continue;                      // being written
+   memcpy( copy, shm, size );
+   __atomic_thread_fence( __ATOMIC_ACQUIRE );
+   after = __atomic_load_n( &shm->seq, __ATOMIC_RELAXED );
+   if( before == after )
+     return 1;
+   }
+return 0;
+}
+
+
+int main( int argc, char *argv[ ] )
+{
+const char *name;
+int fd, interval;
+uint32_t i, *oldRuns;
+struct stat info;
+struct ShmHeader *shm, *copy;
+struct ShmTask *tasks;
+const char *loopUnit, *execUnit;
+
+name = ( argc > 1 ) ? argv[ 1 ] : "/scheduler";
+interval = ( argc > 2 ) ? atoi( argv[ 2 ] ) : 1000;
+if( interval < 100 )
+  interval = 100;
+
+fd = shm_open( name, O_RDONLY, 0 );
+if( fd < 0 || fstat( fd, &info ) != 0 || info.st_size < (off_t)sizeof( struct ShmHeader ) )
+  {
+  fprintf( stderr, "schedtop: cannot open %s\n", name );
+  return 1;
+  }
+shm = (struct ShmHeader *)mmap( NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+close( fd );
+if( shm == MAP_FAILED || shm->magic != SHM_MAGIC || shm->version != SHM_VERSION
+    || shm->size != (uint32_t)info.st_size )
+  {
+  fprintf( stderr, "schedtop: %s not a version %d scheduler segment\n", name, SHM_VERSION );
+  return 1;
+  }
+copy = (struct ShmHeader *)malloc( shm->size );
+oldRuns = (uint32_t *)calloc( shm->tasks, sizeof( uint32_t ) );
+tasks = (struct ShmTask *)( copy + 1 );
+// times from cycle counter are all ns
+loopUnit = shm->clockNs ? "ns" : "ms";
+execUnit = shm->clockNs ? "ns" : "us";
+
+for( ;; )
+   {
+   if( !readSegment( shm, copy, shm->size ) )
+     {
+     usleep( 1000 );
+     continue;
+     }
+   printf( "\033[H\033[J" );        // home and clear screen
+   printf( "Scheduler %s  pid %u  tasks %u  passes %u\n", name, copy->pid,
+           copy->tasks, copy->stats.passes );
+   printf( "Pass %u ms  ran %u  loop max %u %s  exec max %u %s (ID %d)\n",
+           copy->stats.finish - copy->stats.start, copy->stats.qty,
+           copy->stats.maxLoop, loopUnit, copy->stats.maxExec, execUnit,
+           copy->stats.maxID );
+   printf( "Overdue %u ms  max %u  avg %u\n\n", copy->stats.overdue,
+           copy->stats.overdueMax, copy->stats.overdueAvg );
+   printf( "%5s %8s %8s %10s %5s %2s %4s %10s %8s\n", "ID", "Status", "Inter",
+           "Next", "Took", execUnit, "Ran", "Runs", "Runs/s" );
+   for( i = 0; i < copy->tasks; i++ )
+      {
+      printf( "%5u %8d %8d %10u %8u %4d %10u %8.1f\n", i, tasks[ i ].status,
+              tasks[ i ].interval, tasks[ i ].next, tasks[ i ].last,
+              tasks[ i ].executed, tasks[ i ].runs,
+              ( tasks[ i ].runs - oldRuns[ i ] ) * 1000.0 / interval );
+      oldRuns[ i ] = tasks[ i ].runs;
+      }
+   fflush( stdout );
+   usleep( interval * 1000 );
+   }
+return 0;
+}
@@ -0,0 +1,279 @@
+/* teledecode - Decode telemetry stream of Co-operative Scheduler
+
+Author: Paul Carpenter, PC Services, <sales@pcserviceselectronics.co.uk>
+
+Reads binary frames sent by template/ScheduleTele.cpp (build scheduler with
+ENABLE_TELEMETRY and call teleStart), from a file, pipe or serial port
+(set up baud rate first e.g. stty -F /dev/ttyACM0 115200 raw), and rebuilds
+the full task table and statistics after every frame, printed as CSV
+
+    key,seq,tasks,flags                     each keyframe
+    stats,seq,<statistics sent>             each frame, after header line
+    task,seq,ID,next,last,status,interval,executed[,phase]
+                                            each task changed (-a all tasks)
+
+Frames before the first keyframe, after a lost frame or bad CRC are skipped
+until the next keyframe. Totals are sent to stderr at end.
+
+Build
+    g++ -O2 -I../template -o teledecode teledecode.cpp
+
+Usage
+    teledecode [-a] [file]
+
+        -a      print every task every frame, not just ones changed
+        file    stream to read (default stdin)
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ScheduleTele.h"
+
+// Largest decoded frame
+#define MAX_FRAME   ( 1 << 20 )
+
+const char *statNames[ TELE_STAT_FIELDS ] = TELE_STAT_NAMES;
+
+int allTasks = 0;
+int synced = 0;             // keyframe seen and no frames lost since
+int flags, tasks;
+unsigned char seq;
+uint32_t ( *table )[ TELE_TASK_FIELDS ] = NULL;
+uint32_t statValue[ TELE_STAT_FIELDS ];
+unsigned char *changed = NULL;
+unsigned long frames, keyframes, skipped, bad, bytes;
+
+
+/* getVarint - Read varint from frame
+   Returns     int  0 past end of frame
+                    1 value read
+*/
+int getVarint( const unsigned char **pos, const unsigned char *end, uint32_t *value )
+{
+int shift;
+
+*value = 0;
+for( shift = 0; *pos < end && shift < 35; shift += 7 )
+   {
+   *value |= (uint32_t)( **pos & 0x7F ) << shift;
+   if( !( *( *pos )++ & 0x80 ) )
+     return 1;
+   }
+return 0;
+}
+
+
+/* getDelta - Read zigzag difference and add to value */
+int getDelta( const unsigned char **pos, const unsigned char *end, uint32_t *value )
+{
+uint32_t zigzag;
+
+if( !getVarint( pos, end, &zigzag ) )
+  return 0;
+*value += ( zigzag >> 1 ) ^ ( ( zigzag & 1 ) ? 0xFFFFFFFFUL : 0 );
+return 1;
+}
+
+
+/* statMask - Statistics sent for flags of keyframe */
+uint32_t statMask( )
+{
+uint32_t mask;
+
+if( !( flags & TELE_HAS_STATS ) )
+  return 0;
+mask = 0x1FF;
+if( flags & TELE_HAS_BACKGROUND )
+  mask |= 0x600;
+if( flags & TELE_HAS_BUDGET )
+  mask |= 0x800;
+if( flags & TELE_HAS_TICK )
+  mask |= 0x1000;
+if( flags & TELE_HAS_DEGRADE )
+  mask |= 0xE000;
+if( flags & TELE_HAS_RT )
+  mask |= 0x30000;
+return mask;
+}
+
+
+/* frame - Apply decoded frame to table and print it
+   Returns     int  0 bad frame
+                    1 done
+*/
+int frame( const unsigned char *data, int length )
+{
+const unsigned char *pos, *end;
+uint32_t value, mask, have;
+unsigned char crc;
+int i, ID, key;
+
+crc = 0;
+for( i = 0; i < length - 1; i++ )
+   crc = teleCRC( crc, data[ i ] );
+if( length < 4 || crc != data[ length - 1 ] )
+  return 0;
+pos = data;
+end = data + length - 1;
+key = *pos++;
+if( key != TELE_KEY && key != TELE_DELTA )
+  return 0;
+if( key == TELE_KEY )
+  {
+  if( end - pos < 3 || pos[ 1 ] != TELE_VERSION )
+    return 0;
+  seq = *pos;
+  flags = pos[ 2 ];
+  pos += 3;
+  if( !getVarint( &pos, end, &value ) || value > 65535 )
+    return 0;
+  if( table == NULL || (int)value != tasks )
+    {
+    tasks = value;
+    table = (uint32_t (*)[ TELE_TASK_FIELDS ])realloc( table, ( tasks + 1 ) * sizeof( *table ) );
+    changed = (unsigned char *)realloc( changed, tasks + 1 );
+    }
+  memset( table, 0, tasks * sizeof( *table ) );
+  memset( statValue, 0, sizeof( statValue ) );
+  synced = 1;
+  }
+else
+  {
+  if( !synced || *pos != (unsigned char)( seq + 1 ) )
+    {
+    synced = 0;                     // wait for keyframe
+    skipped++;
+    return 1;
+    }
+  seq = *pos++;
+  }
+memset( changed, 0, tasks );
+
+have = statMask( );
+if( have )
+  {
+  if( !getVarint( &pos, end, &mask ) || ( mask & ~have ) )
+    return 0;
+  for( i = 0; i < TELE_STAT_FIELDS; i++ )
+     if( ( mask & ( 1UL << i ) ) && !getDelta( &pos, end, &statValue[ i ] ) )
+       return 0;
+  }
+ID = -1;
+for( ; ; )
+   {
+   if( !getVarint( &pos, end, &value ) )
+     return 0;
+   if( value == 0 )
+     break;
+   ID += value;
+   if( ID >= tasks || pos >= end )
+     return 0;
+   mask = *pos++;
+   for( i = 0; i < TELE_TASK_FIELDS; i++ )
+      if( ( mask & ( 1 << i ) ) && !getDelta( &pos, end, &table[ ID ][ i ] ) )
+        return 0;
+   changed[ ID ] = 1;
+   }
+if( pos != end )
+  return 0;
+
+// print table as it is now
+frames++;
+if( key == TELE_KEY )
+  {
+  keyframes++;
+  printf( "key,%u,%d,%d\n", seq, tasks, flags );
+  if( have )
+    {
+    printf( "stats,seq" );
+    for( i = 0; i < TELE_STAT_FIELDS; i++ )
+       if( have & ( 1UL << i ) )
+         printf( ",%s", statNames[ i ] );
+    printf( "\n" );
+    }
+  printf( "task,seq,ID,next,last,status,interval,executed%s\n",
+          ( flags & TELE_HAS_PHASE ) ? ",phase" : "" );
+  }
+if( have )
+  {
+  printf( "stats,%u", seq );
+  for( i = 0; i < TELE_STAT_FIELDS; i++ )
+     if( have & ( 1UL << i ) )
+       printf( ",%lu", (unsigned long)statValue[ i ] );
+  printf( "\n" );
+  }
+for( ID = 0; ID < tasks; ID++ )
+   if( allTasks || changed[ ID ] )
+     {
+     printf( "task,%u,%d,%lu,%lu,%ld,%ld,%ld", seq, ID,
+             (unsigned long)table[ ID ][ 0 ], (unsigned long)table[ ID ][ 1 ],
+             (long)(int32_t)table[ ID ][ 2 ], (long)(int32_t)table[ ID ][ 3 ],
+             (long)(int32_t)table[ ID ][ 4 ] );
+     if( flags & TELE_HAS_PHASE )
+       printf( ",%ld", (long)(int32_t)table[ ID ][ 5 ] );
+     printf( "\n" );
+     }
+return 1;
+}
+
+
+int main( int argc, char *argv[ ] )
+{
+FILE *in;
+unsigned char *data;
+int c, code, left, length;
+
+in = stdin;
+for( c = 1; c < argc; c++ )
+   if( !strcmp( argv[ c ], "-a" ) )
+     allTasks = 1;
+   else
+     if( ( in = fopen( argv[ c ], "rb" ) ) == NULL )
+       {
+       fprintf( stderr, "teledecode: cannot open %s\n", argv[ c ] );
+       return 1;
+       }
+data = (unsigned char *)malloc( MAX_FRAME );
+
+// COBS decode between 0x00 bytes
+length = 0;
+code = left = 0;
+while( ( c = getc( in ) ) != EOF )
+  {
+  bytes++;
+  if( c == 0 )
+    {
+    if( length > 0 || left > 0 )
+      {
+      if( left > 0 || !frame( data, length ) )
+        {
+        bad++;
+        synced = 0;
+        }
+      fflush( stdout );
+      }
+    length = code = left = 0;
+    continue;
+    }
+  if( length >= MAX_FRAME - 1 )
+    {
+    left = 1;                       // too long, bad when 0x00 found
+    continue;
+    }
+  if( left == 0 )
+    {
+    if( code && code != 255 )
+      data[ length++ ] = 0;
+    code = c;
+    left = c - 1;
+    }
+  else
+    {
+    data[ length++ ] = c;
+    left--;
+    }
+  }
+fprintf( stderr, "teledecode: %lu bytes, %lu frames (%lu keyframes), %lu bytes per frame, %lu skipped, %lu bad\n",
+         bytes, frames, keyframes, frames ? bytes / frames : 0UL, skipped, bad );
+return 0;
+}